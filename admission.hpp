@@ -0,0 +1,500 @@
+/* admission.hpp -- v1.0 -- per-source-address connection admission control
+   Author: Sam Y. 2026
+
+   Connection counts and accept-rate token buckets are kept per source address and per source prefix, in a
+   fixed-size open-addressing table shared by all acceptor threads. Entries are claimed and updated with
+   compare-and-swap only; there is no global lock.
+
+   Each entry holds two words:
+   - state:  44-bit tag (address or prefix fingerprint) and 20-bit count of live connections
+   - bucket: 32-bit timestamp (milliseconds) and 32-bit token count (1/1024 token units)
+
+   Entries are never emptied. An entry with no live connections and a full bucket is reclaimed by the next
+   source that hashes to it. Addresses are identified by a 44-bit fingerprint of a seeded hash, so two sources
+   may rarely share an entry; they then share its limits. */
+
+#ifndef _COMM_ADMISSION_HPP
+#define _COMM_ADMISSION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "client.hpp"
+#include "mem.hpp"
+
+namespace comm {
+
+    //! @struct admission_policy
+    /* limits applied to every accepted connection, per source address and per source prefix; 0 disables a limit
+     */
+    struct admission_policy {
+
+        // Live connections per source address
+        std::uint32_t maxPerAddress;
+        // Live connections per source prefix
+        std::uint32_t maxPerPrefix;
+        // Accepted connections per second per source address
+        std::uint32_t addressRate;
+        // Connections an idle source address may open at once; defaults to addressRate
+        std::uint32_t addressBurst;
+        // Accepted connections per second per source prefix
+        std::uint32_t prefixRate;
+        // Connections an idle source prefix may open at once; defaults to prefixRate
+        std::uint32_t prefixBurst;
+        // Prefix lengths, in bits
+        std::uint8_t ipv4Prefix;
+        std::uint8_t ipv6Prefix;
+
+        //! ctor.
+        admission_policy() : maxPerAddress(0)
+                           , maxPerPrefix(0)
+                           , addressRate(0)
+                           , addressBurst(0)
+                           , prefixRate(0)
+                           , prefixBurst(0)
+                           , ipv4Prefix(24)
+                           , ipv6Prefix(64) {}
+    };
+
+    //! @struct admission_ticket
+    /* table entries charged for a live connection, handed back to admission::release() when it closes
+     */
+    struct admission_ticket {
+
+        static const std::uint32_t NONE = 0xffffffff;
+
+        std::uint32_t address;
+        std::uint32_t prefix;
+
+        //! ctor.
+        admission_ticket() : address(NONE), prefix(NONE) {}
+    };
+
+    //! @class admission
+    /*! decides whether a new connection is admitted, based on its source address
+     *! acquire() and release() may be called concurrently from any thread
+     */
+    class admission {
+    public:
+
+        // Largest connection limit that fits an entry
+        static const std::uint32_t MAX_COUNT = (1u << 20) - 1;
+
+        //! dtor.
+        //
+        ~admission() {
+
+            if (entries_ != nullptr) {
+                resource_->deallocate(entries_, sizeof(entry) * (mask_ + 1), alignof(entry));
+            }
+        }
+
+        //! ctor.
+        //! @param capacity    maximum number of live connections; the table is sized from it
+        //! @param resource    memory resource used for the table, allocated when a policy is first set
+        admission(const std::size_t capacity, memory_resource* const resource)
+            : resource_(resource)
+            , capacity_(capacity)
+            , entries_(nullptr)
+            , mask_(0)
+            , enabled_(false)
+            , rejected_(0)
+            , untracked_(0) {
+
+            seed_ = reinterpret_cast<std::uintptr_t>(this)
+                ^ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        }
+
+        admission(const admission&) = delete;
+        admission& operator=(const admission&) = delete;
+
+        //! Sets admission policy; not safe to call while connections are being accepted
+        //! Connections admitted under a previous policy keep their charges until they close
+        //! @return false if the table could not be allocated
+        bool set_policy(const admission_policy& policy) {
+
+            const std::uint32_t maxCount = MAX_COUNT;
+
+            admission_policy p = policy;
+            p.maxPerAddress = std::min(p.maxPerAddress, maxCount);
+            p.maxPerPrefix = std::min(p.maxPerPrefix, maxCount);
+            p.addressBurst = burst_of(p.addressRate, p.addressBurst);
+            p.prefixBurst = burst_of(p.prefixRate, p.prefixBurst);
+            p.ipv4Prefix = std::min<std::uint8_t>(p.ipv4Prefix, 32);
+            p.ipv6Prefix = std::min<std::uint8_t>(p.ipv6Prefix, 128);
+
+            const bool enabled = p.maxPerAddress != 0 || p.maxPerPrefix != 0 || p.addressRate != 0 || p.prefixRate != 0;
+
+            // Table is allocated once and kept, live tickets refer to it
+            if (enabled && entries_ == nullptr)
+            {
+                // Each live connection pins at most two entries; keep the load factor at or below 1/2
+                std::size_t size = 1024;
+                while (size < capacity_ * 4) {
+                    size *= 2;
+                }
+
+                try {
+                    entries_ = static_cast<entry*>(resource_->allocate(sizeof(entry) * size, alignof(entry)));
+                }
+
+                catch (std::bad_alloc&) {
+                    return false;
+                }
+
+                for (std::size_t i = 0; i != size; ++i) {
+                    new (&entries_[i]) entry();
+                }
+
+                mask_ = size - 1;
+            }
+
+            policy_ = p;
+            enabled_ = enabled;
+            return true;
+        }
+
+        //! @get
+        const admission_policy& get_policy() const {
+
+            return policy_;
+        }
+
+        //! @get
+        //! @return number of connections refused
+        std::size_t get_rejected_count() const {
+
+            return rejected_;
+        }
+
+        //! @get
+        //! @return number of connections admitted without tracking, because the table was full
+        std::size_t get_untracked_count() const {
+
+            return untracked_;
+        }
+
+        //! Charges a new connection against the limits of its source
+        //! Connections of unknown address and Unix-domain connections are always admitted
+        //! @param peer      source address
+        //! @param ticket    [out] charges to hand back to release() once the connection closes
+        //! @return          true if the connection is admitted
+        bool acquire(const peer_address& peer, admission_ticket& ticket) {
+
+            ticket = admission_ticket();
+            if (!enabled_ || (peer.family != AF_INET && peer.family != AF_INET6)) {
+                return true;
+            }
+
+            const std::uint32_t now = (policy_.addressRate != 0 || policy_.prefixRate != 0) ? clock() : 0;
+
+            if (!charge(peer.bytes, ADDRESS, now, ticket.address))
+                return ++rejected_, false;
+
+            // Mask the host bits off; IPv4 addresses are IPv4-mapped, so their prefix starts at bit 96
+            std::uint8_t prefix[16];
+            std::memcpy(prefix, peer.bytes, sizeof(prefix));
+            mask(prefix, peer.family == AF_INET ? 96 + policy_.ipv4Prefix : policy_.ipv6Prefix);
+
+            if (!charge(prefix, PREFIX, now, ticket.prefix))
+            {
+                release(ticket);
+                ticket = admission_ticket();
+                return ++rejected_, false;
+            }
+
+            return true;
+        }
+
+        //! Hands back the charges of a closed connection
+        //! @param ticket    charges returned by acquire()
+        void release(const admission_ticket& ticket) {
+
+            if (ticket.address != admission_ticket::NONE) {
+                entries_[ticket.address].state.fetch_sub(1, std::memory_order_release);
+            }
+
+            if (ticket.prefix != admission_ticket::NONE) {
+                entries_[ticket.prefix].state.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+    private:
+
+        // Entry kinds, stored in the top bit of the tag
+        enum kind { ADDRESS = 0, PREFIX = 1 };
+
+        static const int COUNT_BITS = 20;
+        static const int TAG_BITS = 44;
+        static const std::uint64_t COUNT_MASK = (1ull << COUNT_BITS) - 1;
+        static const std::uint64_t TOKEN = 1024; // One token, in bucket units
+        static const std::size_t PROBE_LIMIT = 16; // Entries inspected before giving up on a lookup
+        static const int RETRY_LIMIT = 4; // Attempts to claim an entry under contention
+
+        //! @struct entry
+        struct entry {
+
+            std::atomic<std::uint64_t> state; // Tag and connection count, 0 if never used
+            std::atomic<std::uint64_t> bucket; // Timestamp and tokens, 0 if full
+
+            entry() : state(0), bucket(0) {}
+        };
+
+        memory_resource*  resource_;
+        std::size_t       capacity_;
+
+        entry*            entries_; // Table, power of two sized
+        std::size_t       mask_;
+        std::uint64_t     seed_; // Hash seed, so that sources cannot aim for the same entry
+
+        admission_policy  policy_;
+        bool              enabled_;
+
+        std::atomic<std::size_t> rejected_;
+        std::atomic<std::size_t> untracked_;
+
+        /*! Defaults and clamps burst, so that a full bucket fits 32 bits
+         */
+        static std::uint32_t burst_of(const std::uint32_t rate, const std::uint32_t burst) {
+
+            if (rate == 0) {
+                return 0;
+            }
+
+            return std::min<std::uint32_t>(burst != 0 ? burst : rate, 0xffffffff / TOKEN);
+        }
+
+        /*! Returns current time in milliseconds; wraps every 49 days, only differences are used
+         */
+        static std::uint32_t clock() {
+
+            return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /*! Clears all but the leading bits of an address
+         */
+        static void mask(std::uint8_t* const bytes, const int bits) {
+
+            for (int i = 0; i != 16; ++i)
+            {
+                const int keep = std::max(0, std::min(8, bits - i * 8));
+                bytes[i] &= static_cast<std::uint8_t>(0xff00 >> keep);
+            }
+        }
+
+        /*! Mixes bits, finalizer of splitmix64
+         */
+        static std::uint64_t mix(std::uint64_t x) {
+
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        /*! Hashes address
+         */
+        std::uint64_t hash(const std::uint8_t* const bytes, const kind k) const {
+
+            std::uint64_t hi, lo;
+            std::memcpy(&hi, bytes, 8);
+            std::memcpy(&lo, bytes + 8, 8);
+            return mix(mix(seed_ ^ k ^ hi) ^ lo);
+        }
+
+        /*! Returns non-zero tag of hash; the top bit holds the kind
+         */
+        static std::uint64_t tag_of(const std::uint64_t h, const kind k) {
+
+            const std::uint64_t tag = ((h >> COUNT_BITS) & ((1ull << (TAG_BITS - 1)) - 1))
+                | (static_cast<std::uint64_t>(k) << (TAG_BITS - 1));
+            return tag != 0 ? tag : 1;
+        }
+
+        /*! Returns tokens in bucket word after refilling up to now, in bucket units
+         */
+        static std::uint64_t tokens_of(const std::uint64_t word,
+                                       const std::uint32_t rate,
+                                       const std::uint32_t burst,
+                                       const std::uint32_t now) {
+
+            const std::uint64_t full = burst * TOKEN;
+            if (word == 0) {
+                return full;
+            }
+
+            // Refilling from empty takes at most 1000 * burst / rate + 1 milliseconds
+            const std::uint64_t elapsed = static_cast<std::uint32_t>(now - static_cast<std::uint32_t>(word >> 32));
+            if (elapsed > static_cast<std::uint64_t>(burst) * 1000 / rate) {
+                return full;
+            }
+
+            return std::min(full, (word & 0xffffffff) + elapsed * rate * TOKEN / 1000);
+        }
+
+        /*! Returns true if the entry can be given to another source
+         */
+        bool reclaimable(const entry& e, const std::uint64_t state, const std::uint32_t now) const {
+
+            if ((state & COUNT_MASK) != 0) {
+                return false;
+            }
+
+            // Sources must not escape their rate limit by having their entry reset
+            const bool prefix = (state >> (COUNT_BITS + TAG_BITS - 1)) & 1;
+            const std::uint32_t rate = prefix ? policy_.prefixRate : policy_.addressRate;
+            const std::uint32_t burst = prefix ? policy_.prefixBurst : policy_.addressBurst;
+
+            return rate == 0 || tokens_of(e.bucket.load(std::memory_order_relaxed), rate, burst, now) == burst * TOKEN;
+        }
+
+        /*! Finds or claims the entry of tag
+         *! @return    entry index, or NONE if the probed entries are all taken
+         */
+        std::uint32_t find(const std::uint64_t h, const std::uint64_t tag, const std::uint32_t now) {
+
+            for (int attempt = 0; attempt != RETRY_LIMIT; ++attempt)
+            {
+                std::size_t candidate = mask_ + 1;
+                std::uint64_t expected = 0;
+
+                for (std::size_t i = 0; i != PROBE_LIMIT; ++i)
+                {
+                    const std::size_t index = (h + i) & mask_;
+                    const std::uint64_t state = entries_[index].state.load(std::memory_order_acquire);
+
+                    if ((state >> COUNT_BITS) == tag) {
+                        return static_cast<std::uint32_t>(index);
+                    }
+
+                    if (candidate == mask_ + 1 && (state == 0 || reclaimable(entries_[index], state, now)))
+                    {
+                        candidate = index;
+                        expected = state;
+                    }
+
+                    // Entries are never emptied, so nothing was ever stored past an empty one
+                    if (state == 0) {
+                        break;
+                    }
+                }
+
+                if (candidate == mask_ + 1) {
+                    return admission_ticket::NONE;
+                }
+
+                if (entries_[candidate].state.compare_exchange_strong(expected, tag << COUNT_BITS))
+                {
+                    // Reclaimed entries start with a full bucket
+                    if (expected != 0) {
+                        entries_[candidate].bucket.store(0, std::memory_order_relaxed);
+                    }
+
+                    return static_cast<std::uint32_t>(candidate);
+                }
+            }
+
+            return admission_ticket::NONE;
+        }
+
+        /*! Takes one token from bucket
+         */
+        static bool take(std::atomic<std::uint64_t>& bucket,
+                         const std::uint32_t rate,
+                         const std::uint32_t burst,
+                         const std::uint32_t now) {
+
+            std::uint64_t word = bucket.load(std::memory_order_relaxed);
+            while (true)
+            {
+                const std::uint64_t tokens = tokens_of(word, rate, burst, now);
+                if (tokens < TOKEN) {
+                    return false;
+                }
+
+                if (bucket.compare_exchange_weak(word, (static_cast<std::uint64_t>(now) << 32) | (tokens - TOKEN))) {
+                    return true;
+                }
+            }
+        }
+
+        /*! Charges one connection to the entry of address
+         *! @param index    [out] entry to release once the connection closes, NONE if not counted
+         *! @return         false if a limit is reached
+         */
+        bool charge(const std::uint8_t* const bytes, const kind k, const std::uint32_t now, std::uint32_t& index) {
+
+            const std::uint32_t limit = k == PREFIX ? policy_.maxPerPrefix : policy_.maxPerAddress;
+            const std::uint32_t rate = k == PREFIX ? policy_.prefixRate : policy_.addressRate;
+            const std::uint32_t burst = k == PREFIX ? policy_.prefixBurst : policy_.addressBurst;
+
+            index = admission_ticket::NONE;
+            if (limit == 0 && rate == 0) {
+                return true;
+            }
+
+            const std::uint64_t h = hash(bytes, k);
+            const std::uint64_t tag = tag_of(h, k);
+
+            for (int attempt = 0; attempt != RETRY_LIMIT; ++attempt)
+            {
+                std::uint32_t i;
+                if ((i = find(h, tag, now)) == admission_ticket::NONE) {
+                    break;
+                }
+
+                entry& e = entries_[i];
+
+                // A counted entry cannot be reclaimed; without a count limit, a token may rarely be
+                // taken from an entry that was just reclaimed by another source
+                if (limit != 0)
+                {
+                    std::uint64_t state = e.state.load(std::memory_order_relaxed);
+                    do
+                    {
+                        if ((state >> COUNT_BITS) != tag) {
+                            break;
+                        }
+
+                        if ((state & COUNT_MASK) >= limit) {
+                            return false;
+                        }
+                    }
+                    while (!e.state.compare_exchange_weak(state, state + 1, std::memory_order_acquire));
+
+                    // Reclaimed since it was found
+                    if ((state >> COUNT_BITS) != tag) {
+                        continue;
+                    }
+
+                    index = i;
+                }
+
+                if (rate != 0 && !take(e.bucket, rate, burst, now))
+                {
+                    if (index != admission_ticket::NONE)
+                    {
+                        e.state.fetch_sub(1, std::memory_order_release);
+                        index = admission_ticket::NONE;
+                    }
+
+                    return false;
+                }
+
+                return true;
+            }
+
+            ++untracked_;
+            return true;
+        }
+    };
+}
+
+#endif
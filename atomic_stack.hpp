@@ -129,7 +129,32 @@ namespace comm {
             {}
         }
 
+        /*! Pushes a pre-linked list of nodes to top of stack
+         *! @param first    top of list
+         *! @param last     bottom of list, its next pointer is overwritten
+         */
+        void push_list(atomic_node<T>* first, atomic_node<T>* last) {
+
+            last->next = head_.load();
+
+            while (!atomic_compare_exchange_weak_explicit(&head_,
+                                                          &last->next,
+                                                          first,
+                                                          std::memory_order_release,
+                                                          std::memory_order_relaxed))
+            {}
+        }
+
+        /*! Detaches every node from the stack; not safe against a concurrent pop(), see below
+         *! @return    former top of stack, linked through next
+         */
+        atomic_node<T>* pop_all() {
+            return head_.exchange(nullptr);
+        }
+
         /*! Pops from top of stack
+         *! The head carries no ABA tag: pushes may run concurrently, but pop() and pop_all() must be serialized
+         *! by the caller, or a node popped and pushed back meanwhile lets a stale next pointer become the head
          */
         T* pop() {
 
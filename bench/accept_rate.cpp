@@ -0,0 +1,255 @@
+/* accept_rate.cpp -- v1.0 -- compares connection accept pipelines
+   Author: Sam Y. 2026
+
+   legacy:  accept(), fcntl(F_GETFL), fcntl(F_SETFL), epoll_ctl(ADD) per connection
+   accept4: accept4(SOCK_NONBLOCK | SOCK_CLOEXEC) per connection, registered with epoll_ctl(ADD) in batches
+
+   Each pipeline runs on one thread while client threads connect and reset as fast as they can. The benchmark
+   counts the syscalls it issues, including the epoll_wait() and the failing accept() that end each batch.
+   Accepted sockets are closed right after registration; close() is not counted. */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "server/endpoint.hpp"
+
+namespace {
+
+    static const int BATCH_SIZE = 64;
+
+    //! @struct result
+    /*! Pipeline measurement
+     */
+    struct result {
+        std::size_t connections;
+        std::size_t syscalls;
+    };
+
+    /*! Helper
+     *! Outputs usage statement to stdout
+     */
+    inline void print_usage(const char* app)
+    {
+        ::printf("Usage: %s [-ctph]\n"
+                 "  [-h, --help]\n"
+                 "  [-c, --clients=<number of connecting threads>] (default: 4)\n"
+                 "  [-t, --time=<seconds per measurement>] (default: 3)\n"
+                 "  [-p, --port=<first server port>] (default: 8290)\n"
+                 , app);
+    }
+
+    /*! Helper
+     *! Raises the descriptor limit to the hard limit
+     */
+    inline void raise_descriptor_limit()
+    {
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    /*! Connects and resets until told to stop
+     */
+    void storm(const int port, std::atomic<bool>& running)
+    {
+        const linger reset = { 1, 0 };
+
+        while (running.load())
+        {
+            int sfd;
+            if ((sfd = comm::endpoint_tcp()) == -1)
+                continue;
+
+            if (comm::endpoint_connect(sfd, "127.0.0.1", port) == 0) {
+                ::setsockopt(sfd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            }
+
+            comm::endpoint_close(sfd);
+        }
+    }
+
+    /*! Registers client socket
+     */
+    inline int add(const int epfd, const int cfd)
+    {
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLPRI | EPOLLONESHOT;
+        event.data.fd = cfd;
+        return ::epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &event);
+    }
+
+    /*! Drains listener with accept() and two fcntl() calls per connection
+     */
+    void accept_legacy(const int sfd, const int epfd, result& res)
+    {
+        int cfd;
+        while ((++res.syscalls, cfd = comm::endpoint_accept(sfd)) != -1)
+        {
+            res.syscalls += 2;
+            if (comm::endpoint_unblock(cfd) == 0)
+            {
+                ++res.syscalls;
+                add(epfd, cfd);
+                ++res.connections;
+            }
+
+            comm::endpoint_close(cfd);
+        }
+    }
+
+    /*! Drains listener with accept4() in batches
+     */
+    void accept_batched(const int sfd, const int epfd, result& res)
+    {
+        int cfds[BATCH_SIZE];
+
+        int count;
+        do
+        {
+            count = 0;
+            while (count != BATCH_SIZE
+                   && (++res.syscalls, cfds[count] = comm::endpoint_accept_nonblock(sfd)) != -1) {
+                ++count;
+            }
+
+            for (int i = 0; i != count; ++i)
+            {
+                ++res.syscalls;
+                add(epfd, cfds[i]);
+                ++res.connections;
+                comm::endpoint_close(cfds[i]);
+            }
+        }
+        while (count == BATCH_SIZE);
+    }
+
+    /*! Runs a pipeline for the given duration
+     */
+    result measure(void (*pipeline)(int, int, result&), const int clientCount, const int seconds, const int port)
+    {
+        result res = {};
+
+        int sfd;
+        if ((sfd = comm::endpoint_tcp_server(port, 4096)) == -1 || comm::endpoint_unblock(sfd) == -1)
+            return res;
+
+        // Listener epoll, and client epoll that accepted sockets are registered with
+        const int listenfd = ::epoll_create1(0);
+        const int epfd = ::epoll_create1(0);
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLET;
+        event.data.fd = sfd;
+        ::epoll_ctl(listenfd, EPOLL_CTL_ADD, sfd, &event);
+
+        std::atomic<bool> running(true);
+
+        std::vector<std::thread> clients;
+        for (int i = 0; i != clientCount; ++i) {
+            clients.emplace_back(storm, port, std::ref(running));
+        }
+
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()
+            + std::chrono::seconds(seconds);
+
+        while (std::chrono::steady_clock::now() < end)
+        {
+            epoll_event events[1];
+
+            ++res.syscalls;
+            if (::epoll_wait(listenfd, events, 1, 10) == 1) {
+                pipeline(sfd, epfd, res);
+            }
+        }
+
+        running.store(false);
+        for (std::size_t i = 0; i != clients.size(); ++i) {
+            clients[i].join();
+        }
+
+        comm::endpoint_close(epfd);
+        comm::endpoint_close(listenfd);
+        comm::endpoint_close(sfd);
+
+        return res;
+    }
+
+    /*! Prints measurement
+     */
+    void print(const char* name, const result& res, const int seconds)
+    {
+        if (res.connections == 0)
+        {
+            ::printf("  %-10s %16s\n", name, "no connections");
+            return;
+        }
+
+        ::printf("  %-10s %16.0f %18.2f\n",
+                 name,
+                 static_cast<double>(res.connections) / seconds,
+                 static_cast<double>(res.syscalls) / res.connections);
+    }
+}
+
+/*! Entry point
+ */
+int main(int argc, char** argv)
+{
+    int clientCount = 4;
+    int seconds = 3;
+    int port = 8290;
+
+    // CLI options
+    const option longOptions[] = {
+        { "help",     no_argument,       nullptr, 'h' },
+        { "clients=", required_argument, nullptr, 'c' },
+        { "time=",    required_argument, nullptr, 't' },
+        { "port=",    required_argument, nullptr, 'p' },
+        { 0, 0, 0, 0 }
+    };
+
+    // Parse command line options...
+    int opt, optindex;
+    while ((opt = getopt_long(argc, argv, "c:t:p:h", longOptions, &optindex)) != -1)
+    {
+        switch (opt)
+        {
+            case 'c': clientCount = ::atoi(optarg); break;
+            case 't': seconds = ::atoi(optarg); break;
+            case 'p': port = ::atoi(optarg); break;
+
+            default:
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+        }
+    }
+
+    if (clientCount <= 0 || seconds <= 0 || port <= 0) {
+        return print_usage(argv[0]), 1;
+    }
+
+    raise_descriptor_limit();
+
+    ::printf("> %d connecting threads, %d s per measurement\n\n", clientCount, seconds);
+    ::printf("  %-10s %16s %18s\n", "pipeline", "connections / s", "syscalls / conn.");
+
+    print("legacy", measure(accept_legacy, clientCount, seconds, port), seconds);
+    print("accept4", measure(accept_batched, clientCount, seconds, port + 1), seconds);
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+/* accept_storm.cpp -- v1.0 -- measures connection accept rate versus acceptor thread count
+   Author: Sam Y. 2026
+
+   Client threads open and immediately reset connections to the server as fast as they can, simulating a
+   reconnect storm. Closing with SO_LINGER 0 avoids exhausting ephemeral ports on TIME_WAIT.
+
+   Acceptor threads take client slots concurrently while workers return them. Once the storm is over, every
+   connection must be gone and every descriptor closed; a slot handed to two connections at once loses one
+   of them, which shows up as a leaked descriptor. */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <getopt.h>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "server/server.hpp"
+
+/*! @class sink
+ *! Client packet handler, discards input
+ */
+class sink : public comm::client_callback_handler<sink> {
+public:
+
+    inline sink(const std::size_t nworkers,
+                const std::size_t size) : comm::client_callback_handler<sink>(nworkers, size) {}
+};
+
+namespace {
+    /*! Helper
+     *! Outputs usage statement to stdout
+     */
+    inline void print_usage(const char* app)
+    {
+        ::printf("Usage: %s [-actph]\n"
+                 "  [-h, --help]\n"
+                 "  [-a, --acceptors=<maximum number of acceptor threads>] (default: # of CPUs)\n"
+                 "  [-c, --clients=<number of connecting threads>] (default: 4)\n"
+                 "  [-t, --time=<seconds per measurement>] (default: 3)\n"
+                 "  [-p, --port=<first server port>] (default: 8190)\n"
+                 , app);
+    }
+
+    /*! Helper
+     *! Raises the descriptor limit to the hard limit
+     */
+    inline void raise_descriptor_limit()
+    {
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    /*! Helper
+     *! Returns the number of open descriptors of the process, -1 on error
+     */
+    inline int count_descriptors()
+    {
+        DIR* dir;
+        if ((dir = ::opendir("/proc/self/fd")) == nullptr)
+            return -1;
+
+        // Less the directory's own descriptor, and the . and .. entries
+        int count = -3;
+        while (::readdir(dir) != nullptr) {
+            ++count;
+        }
+
+        ::closedir(dir);
+        return count;
+    }
+
+    /*! Connects and resets until told to stop
+     */
+    void storm(const int port, std::atomic<bool>& running, std::atomic<std::size_t>& connected)
+    {
+        const linger reset = { 1, 0 };
+
+        while (running.load())
+        {
+            int sfd;
+            if ((sfd = comm::endpoint_tcp()) == -1)
+                continue;
+
+            if (comm::endpoint_connect(sfd, "127.0.0.1", port) == 0)
+            {
+                ++connected;
+                ::setsockopt(sfd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            }
+
+            comm::endpoint_close(sfd);
+        }
+    }
+
+    /*! Measures connection rate with the given number of acceptors
+     *! @param leaked    [out] connections left open or descriptors leaked once the storm is over
+     *! @return          connections per second, -1 on error
+     */
+    double measure(const std::size_t acceptorCount,
+                   const int clientCount,
+                   const int seconds,
+                   const int port,
+                   int* leaked)
+    {
+        comm::server<sink> sv(1, 1e5);
+
+        if (!sv.set_acceptor_count(acceptorCount) || !sv.bind(port, 4096))
+            return -1;
+
+        const int descriptors = count_descriptors();
+        std::thread server(&comm::server<sink>::run, &sv);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::atomic<bool> running(true);
+        std::atomic<std::size_t> connected(0);
+
+        std::vector<std::thread> clients;
+        for (int i = 0; i != clientCount; ++i) {
+            clients.emplace_back(storm, port, std::ref(running), std::ref(connected));
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        running.store(false);
+
+        for (std::size_t i = 0; i != clients.size(); ++i) {
+            clients[i].join();
+        }
+
+        // Workers close the reset connections shortly after
+        for (int i = 0; i != 100 && sv.get_active_count() != 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        *leaked = static_cast<int>(sv.get_active_count()) + count_descriptors() - descriptors;
+
+        sv.stop();
+        server.join();
+
+        return static_cast<double>(connected.load()) / seconds;
+    }
+}
+
+/*! Entry point
+ */
+int main(int argc, char** argv)
+{
+    int maxAcceptors = static_cast<int>(std::thread::hardware_concurrency());
+    int clientCount = 4;
+    int seconds = 3;
+    int port = 8190;
+
+    // CLI options
+    const option longOptions[] = {
+        { "help",       no_argument,       nullptr, 'h' },
+        { "acceptors=", required_argument, nullptr, 'a' },
+        { "clients=",   required_argument, nullptr, 'c' },
+        { "time=",      required_argument, nullptr, 't' },
+        { "port=",      required_argument, nullptr, 'p' },
+        { 0, 0, 0, 0 }
+    };
+
+    // Parse command line options...
+    int opt, optindex;
+    while ((opt = getopt_long(argc, argv, "a:c:t:p:h", longOptions, &optindex)) != -1)
+    {
+        switch (opt)
+        {
+            case 'a': maxAcceptors = ::atoi(optarg); break;
+            case 'c': clientCount = ::atoi(optarg); break;
+            case 't': seconds = ::atoi(optarg); break;
+            case 'p': port = ::atoi(optarg); break;
+
+            default:
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+        }
+    }
+
+    if (maxAcceptors <= 0 || clientCount <= 0 || seconds <= 0 || port <= 0) {
+        return print_usage(argv[0]), 1;
+    }
+
+    raise_descriptor_limit();
+
+    ::printf("> %d connecting threads, %d s per measurement\n\n", clientCount, seconds);
+    ::printf("  %-12s %16s %8s\n", "acceptors", "connections / s", "leaked");
+
+    // Powers of two, then the maximum
+    int failed = 0;
+    for (int acceptors = 1; ; acceptors = acceptors * 2 < maxAcceptors ? acceptors * 2 : maxAcceptors)
+    {
+        int leaked = 0;
+        const double rate = measure(acceptors, clientCount, seconds, port++, &leaked);
+        if (rate < 0)
+            ::printf("  %-12d %16s\n", acceptors, "bind failed");
+        else
+            ::printf("  %-12d %16.0f %8d\n", acceptors, rate, leaked);
+
+        failed += leaked != 0;
+
+        if (acceptors == maxAcceptors)
+            break;
+    }
+
+    return failed != 0 ? 2 : 0;
+}
@@ -0,0 +1,310 @@
+/* dispatch.cpp -- v1.0 -- measures cache behaviour of the client event dispatch loop
+   Author: Sam Y. 2026
+
+   A single worker is held inside a handler while one byte is written to every connection, so that
+   the next epoll_wait() returns all of them as one batch. Hardware counters (user space only) are
+   read around the dispatch of that batch. */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <thread>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include "server/server.hpp"
+
+namespace {
+
+    //! @struct counters
+    /*! Hardware counters of the calling thread
+     */
+    struct counters {
+
+        enum { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, COUNT };
+
+        int fds[COUNT];
+
+        //! ctor.
+        counters() {
+
+            const std::uint64_t configs[COUNT] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_CACHE_MISSES
+            };
+
+            const std::uint32_t types[COUNT] = {
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HW_CACHE,
+                PERF_TYPE_HARDWARE
+            };
+
+            for (int i = 0; i != COUNT; ++i)
+            {
+                perf_event_attr attr = {};
+                attr.size = sizeof(attr);
+                attr.type = types[i];
+                attr.config = configs[i];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+
+                fds[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+        }
+
+        //! dtor.
+        ~counters() {
+
+            for (int i = 0; i != COUNT; ++i)
+            {
+                if (fds[i] != -1) {
+                    ::close(fds[i]);
+                }
+            }
+        }
+
+        //! Reads all counters, unavailable counters read 0
+        void read(std::uint64_t* values) const {
+
+            for (int i = 0; i != COUNT; ++i)
+            {
+                values[i] = 0;
+                if (fds[i] != -1 && ::read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i])) {
+                    values[i] = 0;
+                }
+            }
+        }
+
+        //! @get
+        bool available(int i) const {
+            return fds[i] != -1;
+        }
+    };
+
+    // Shared state between the benchmark driver and the worker
+    std::atomic<int> gateFd(-1);
+    std::atomic<bool> gated(false);
+    std::atomic<bool> released(false);
+    std::atomic<bool> done(false);
+    std::atomic<std::size_t> dispatched(0);
+    std::size_t batchSize = 0;
+
+    std::uint64_t begin[counters::COUNT];
+    std::uint64_t end[counters::COUNT];
+    std::chrono::steady_clock::time_point beginTime;
+    std::chrono::steady_clock::time_point endTime;
+
+    // Counters of the worker thread, opened on first use
+    counters* workerCounters = nullptr;
+}
+
+/*! @class sink
+ *! Client packet handler, counts dispatched events
+ */
+class sink : public comm::client_callback_handler<sink> {
+public:
+
+    inline sink(const std::size_t nworkers,
+                const std::size_t size) : comm::client_callback_handler<sink>(nworkers, size) {}
+
+    inline void on_input(int sfd, char*, int) {
+
+        // Hold the worker until every connection is readable
+        if (sfd == gateFd.load())
+        {
+            if (workerCounters == nullptr) {
+                workerCounters = new counters();
+            }
+
+            gated.store(true);
+            while (!released.load()) {
+                std::this_thread::yield();
+            }
+
+            released.store(false);
+            beginTime = std::chrono::steady_clock::now();
+            workerCounters->read(begin);
+            return;
+        }
+
+        if (++dispatched == batchSize)
+        {
+            workerCounters->read(end);
+            endTime = std::chrono::steady_clock::now();
+            done.store(true);
+        }
+    }
+};
+
+namespace {
+    /*! Helper
+     *! Outputs usage statement to stdout
+     */
+    inline void print_usage(const char* app)
+    {
+        ::printf("Usage: %s [-nrh]\n"
+                 "  [-h, --help]\n"
+                 "  [-n, --client-count=<number of connections>] (default: 10,000)\n"
+                 "  [-r, --rounds=<number of measured batches>] (default: 10)\n"
+                 , app);
+    }
+
+    /*! Helper
+     *! Raises the descriptor limit to the hard limit
+     */
+    inline void raise_descriptor_limit()
+    {
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+}
+
+/*! Entry point
+ */
+int main(int argc, char** argv)
+{
+    int clientCount = 10000;
+    int rounds = 10;
+
+    // CLI options
+    const option longOptions[] = {
+        { "help",          no_argument,       nullptr, 'h' },
+        { "client-count=", required_argument, nullptr, 'n' },
+        { "rounds=",       required_argument, nullptr, 'r' },
+        { 0, 0, 0, 0 }
+    };
+
+    // Parse command line options...
+    int opt, optindex;
+    while ((opt = getopt_long(argc, argv, "n:r:h", longOptions, &optindex)) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+            {
+                if ((clientCount = ::atoi(optarg)) <= 0) {
+                    return ::fprintf(stderr, "There needs to be at least 1 connection\n"), 1;
+                }
+
+                break;
+            }
+
+            case 'r':
+            {
+                if ((rounds = ::atoi(optarg)) <= 0) {
+                    return ::fprintf(stderr, "There needs to be at least 1 round\n"), 1;
+                }
+
+                break;
+            }
+
+            default:
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+        }
+    }
+
+    raise_descriptor_limit();
+
+    sink pool(1, clientCount + 1);
+
+    // Generate connections; the pool owns one end of each pair
+    std::vector<int> peers;
+    for (int i = 0; i != clientCount + 1; ++i)
+    {
+        int pair[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == -1)
+            return ::perror("socketpair"), 1;
+
+        if (comm::endpoint_unblock(pair[0]) == -1 || !pool.add_client(pair[0]))
+            return ::fprintf(stderr, "Cannot add connection %d\n", i), 1;
+
+        if (i == 0)
+            gateFd.store(pair[0]);
+        peers.push_back(pair[1]);
+    }
+
+    batchSize = clientCount;
+    pool.run();
+
+    double cycles = 0, instructions = 0, l1dMisses = 0, llcMisses = 0, nanoseconds = 0;
+
+    const char ch = '$';
+    for (int round = 0; round != rounds + 1; ++round)
+    {
+        // Park the worker
+        comm::endpoint_write(peers[0], &ch, sizeof(ch));
+        while (!gated.load()) {
+            std::this_thread::yield();
+        }
+
+        gated.store(false);
+        dispatched.store(0);
+        done.store(false);
+
+        for (int i = 1; i != clientCount + 1; ++i) {
+            comm::endpoint_write(peers[i], &ch, sizeof(ch));
+        }
+
+        // Release the worker and wait for the batch
+        released.store(true);
+        while (!done.load()) {
+            std::this_thread::yield();
+        }
+
+        // First round warms up caches and page tables
+        if (round == 0) {
+            continue;
+        }
+
+        cycles += end[counters::CYCLES] - begin[counters::CYCLES];
+        instructions += end[counters::INSTRUCTIONS] - begin[counters::INSTRUCTIONS];
+        l1dMisses += end[counters::L1D_MISSES] - begin[counters::L1D_MISSES];
+        llcMisses += end[counters::LLC_MISSES] - begin[counters::LLC_MISSES];
+        nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - beginTime).count();
+    }
+
+    pool.stop();
+
+    const double events = static_cast<double>(clientCount) * rounds;
+
+    ::printf("> %d connections, %d rounds, sizeof(client record) = %zu bytes\n\n",
+             clientCount, rounds, sizeof(comm::atomic_node<comm::client>));
+    ::printf("  %-24s %12.1f\n", "ns / event", nanoseconds / events);
+
+    const char* names[counters::COUNT] = { "cycles / event", "instructions / event",
+                                           "L1D read misses / event", "LLC misses / event" };
+    const double values[counters::COUNT] = { cycles, instructions, l1dMisses, llcMisses };
+
+    for (int i = 0; i != counters::COUNT; ++i)
+    {
+        if (workerCounters->available(i))
+            ::printf("  %-24s %12.2f\n", names[i], values[i] / events);
+        else
+            ::printf("  %-24s %12s\n", names[i], "unavailable");
+    }
+
+    for (std::size_t i = 0; i != peers.size(); ++i) {
+        ::close(peers[i]);
+    }
+
+    return 0;
+}
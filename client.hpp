@@ -1,27 +1,170 @@
 /* client.hpp -- v1.0 -- the client data structure, containing file descriptor and pointer to buffer
-   Author: Sam Y. 2021-22 */
+   Author: Sam Y. 2021-22
+
+   client.hpp -- v1.1
+   Modified: Clients are identified by a stable handle made of slot index and generation
+
+   client.hpp -- v1.2
+   Modified: Read buffer moved out of the client record, records are sized to pack cache lines
+
+   client.hpp -- v1.3
+   Modified: Added peer address
+
+   client.hpp -- v1.4
+   Modified: Connection state bits are atomic, and track activity and ownership of the slot
+
+   client.hpp -- v1.5
+   Modified: Connection state tracks activity between buffer sweeps, and shrunk socket buffers
+
+   client.hpp -- v1.6
+   Modified: Connection state tracks tasks posted to the connection's strand */
 
 #ifndef _COMM_CLIENT_HPP
 #define _COMM_CLIENT_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include <netinet/in.h>
+
 namespace comm {
 
     static const int MAX_READ_SIZE = 4096;
 
+    static const int CACHE_LINE_SIZE = 64;
+
+    //! @struct handle
+    /* stable connection identifier; slot index in the low word, slot generation in the high word.
+       A handle outlives its connection: once the slot is reused the generation no longer matches
+     */
+    struct handle {
+
+        std::uint64_t id;
+
+        //! ctor.
+        handle() : id(0) {}
+        //! ctor.
+        explicit handle(std::uint64_t id) : id(id) {}
+        //! ctor.
+        handle(std::uint32_t index, std::uint32_t generation)
+            : id((static_cast<std::uint64_t>(generation) << 32) | index) {}
+
+        //! @get
+        std::uint32_t index() const {
+            return static_cast<std::uint32_t>(id);
+        }
+
+        //! @get
+        std::uint32_t generation() const {
+            return static_cast<std::uint32_t>(id >> 32);
+        }
+
+        bool operator==(const handle& other) const {
+            return id == other.id;
+        }
+
+        bool operator!=(const handle& other) const {
+            return id != other.id;
+        }
+    };
+
     //! @struct client
-    /* remote connection endpoint
+    /* remote connection endpoint; only fields touched on every event are kept here,
+       the read buffer is stored separately (see client_buffer)
      */
     struct client {
 
         static const int size = MAX_READ_SIZE;
 
+        // State bits
+        enum : std::uint32_t {
+            USED = 1, // Slot holds a connection
+            BUSY = 2, // A worker is processing the connection
+            EVICTED = 4, // Connection is being evicted, events are ignored
+            REFERENCED = 8, // Connection was active since the last eviction sweep
+            TOUCHED = 16, // Connection was active since the last buffer sweep
+            SHRUNK = 32, // Socket buffers are shrunk while the connection is idle
+            QUEUED = 64, // Tasks were posted to the strand, the owner runs them before leaving
+            SCHEDULED = 128 // Slot waits on the ready queue for a worker to run its strand
+        };
+
+        // Events that arrive while the connection is busy are stored above the state bits
+        static const int PENDING_SHIFT = 8;
+
         int sfd;
-        char buff[size + 1];
+        // Slot index, fixed for the life of the slot
+        std::uint32_t index;
+        // Incremented every time the slot is released; never 0
+        std::atomic<std::uint32_t> generation;
+        // Connection state bits, and pending events
+        std::atomic<std::uint32_t> flags;
+        // Total bytes received
+        std::uint64_t received;
 
         //! ctor.
-        client() : sfd(0) {}
+        client() : sfd(0), index(0), generation(1), flags(0), received(0) {}
+        //! ctor.
+        explicit client(int sfd) : sfd(sfd), index(0), generation(1), flags(0), received(0) {}
+
+        //! @get
+        handle get_handle() const {
+            return handle(index, generation.load(std::memory_order_relaxed));
+        }
+    };
+
+    //! @struct peer_address
+    /* remote address of a connection; IPv4 addresses are stored IPv4-mapped, so that every address is 16 bytes
+     */
+    struct peer_address {
+
+        // AF_INET, AF_INET6, AF_UNIX, or AF_UNSPEC if unknown
+        std::uint16_t family;
+        // Port, host byte order
+        std::uint16_t port;
+        // Address, network byte order
+        std::uint8_t bytes[16];
+
         //! ctor.
-        explicit client(int sfd) : sfd(sfd) {}
+        peer_address() : family(AF_UNSPEC), port(0), bytes() {}
+        //! ctor.
+        explicit peer_address(const sockaddr* addr) : family(AF_UNSPEC), port(0), bytes() {
+
+            if (addr->sa_family == AF_INET)
+            {
+                const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(addr);
+                family = AF_INET;
+                port = ntohs(in->sin_port);
+                bytes[10] = bytes[11] = 0xff;
+                std::memcpy(&bytes[12], &in->sin_addr, 4);
+            }
+
+            else if (addr->sa_family == AF_INET6)
+            {
+                const sockaddr_in6* in6 = reinterpret_cast<const sockaddr_in6*>(addr);
+                // IPv4 peers of dual-stack listeners arrive IPv4-mapped
+                family = IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr) ? AF_INET : AF_INET6;
+                port = ntohs(in6->sin6_port);
+                std::memcpy(bytes, &in6->sin6_addr, 16);
+            }
+
+            // Unix-domain peers have no usable address
+            else if (addr->sa_family == AF_UNIX) {
+                family = AF_UNIX;
+            }
+        }
+    };
+
+    //! @struct no_context
+    /* default, empty per-connection context
+     */
+    struct no_context {};
+
+    //! @struct client_buffer
+    /* client read buffer, cold storage kept apart from the client record
+     */
+    struct client_buffer {
+        char data[client::size + 1];
     };
 }
 
@@ -1,40 +1,253 @@
 /* endpoint.hpp -- v1.0 -- contains socket read, write and fcntl functions
-   Author: Sam Y. 2021 */
+   Author: Sam Y. 2021
+
+   endpoint.hpp -- v1.1
+   Modified: Server sockets can join a SO_REUSEPORT group
+
+   endpoint.hpp -- v1.2
+   Modified: Added accept4-based accept and TCP_DEFER_ACCEPT
+
+   endpoint.hpp -- v1.3
+   Modified: accept4-based accept can return the peer address
+
+   endpoint.hpp -- v1.4
+   Modified: SO_REUSEPORT groups can steer connections by receiving CPU
+
+   endpoint.hpp -- v1.5
+   Modified: Added IPv6 and Unix-domain stream sockets; server and accept functions are family-agnostic
+
+   endpoint.hpp -- v1.6
+   Modified: Listeners take a socket option profile, set before listen() and inherited by accepted sockets
+
+   endpoint.hpp -- v1.7
+   Modified: Added socket buffer resizing, and the kernel memory of a socket
+
+   endpoint.hpp -- v1.8
+   Modified: Added Unix-domain packet sockets, and passing descriptors between processes */
 
 #ifndef _COMM_ENDPOINT_HPP
 #define _COMM_ENDPOINT_HPP
 
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
 #include <fcntl.h>
+#include <unistd.h>
 
 #include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/sock_diag.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 
 namespace comm {
 
+    //! @struct socket_options
+    /* TCP options of a listener and the connections it accepts; 0 leaves the system default.
+       All but quickAck are set on the listener before listen(), and accepted sockets inherit them from it
+     */
+    struct socket_options {
+
+        // TCP_DEFER_ACCEPT, seconds; connections are only accepted once they have data to read, or after the timeout
+        int deferAccept;
+        // TCP_FASTOPEN, queue length of pending Fast Open requests; needs bit 2 of net.ipv4.tcp_fastopen
+        int fastOpen;
+        // TCP_NODELAY
+        bool noDelay;
+        // TCP_QUICKACK; set on every accepted socket, as it is not inherited and the kernel may clear it later
+        bool quickAck;
+        // SO_KEEPALIVE is set if any of these is non-zero; TCP_KEEPIDLE and TCP_KEEPINTVL in seconds, TCP_KEEPCNT
+        int keepIdle;
+        int keepInterval;
+        int keepCount;
+        // TCP_USER_TIMEOUT, milliseconds
+        unsigned userTimeout;
+        // SO_RCVBUF and SO_SNDBUF, bytes; the kernel doubles the value
+        int receiveBuffer;
+        int sendBuffer;
+        // SO_INCOMING_CPU of the listener, -1 leaves it unset; the kernel prefers the SO_REUSEPORT listener of
+        // the CPU that received the connection
+        int incomingCpu;
+        // TCP_NOTSENT_LOWAT, bytes
+        unsigned notSentLowat;
+
+        //! ctor.
+        socket_options() : deferAccept(0)
+                         , fastOpen(0)
+                         , noDelay(false)
+                         , quickAck(false)
+                         , keepIdle(0)
+                         , keepInterval(0)
+                         , keepCount(0)
+                         , userTimeout(0)
+                         , receiveBuffer(0)
+                         , sendBuffer(0)
+                         , incomingCpu(-1)
+                         , notSentLowat(0) {}
+    };
+
+    //! Delays accept() until data arrives on the connection, or the timeout expires
+    //! @param seconds    timeout in seconds, 0 disables
+    inline int endpoint_defer_accept(const int sfd, const int seconds)
+    {
+        return ::setsockopt(sfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds));
+    }
+
+    //! Sets the inheritable options of a profile, i.e. all but TCP_QUICKACK
+    //! Buffer sizes only take effect on connections if set before listen() or connect()
+    inline int endpoint_set_options(const int sfd, const socket_options& options)
+    {
+        const int on = 1;
+        const bool keepalive = options.keepIdle != 0 || options.keepInterval != 0 || options.keepCount != 0;
+
+        if ((options.deferAccept != 0 && endpoint_defer_accept(sfd, options.deferAccept) == -1)
+            || (options.fastOpen != 0
+                && ::setsockopt(sfd, IPPROTO_TCP, TCP_FASTOPEN, &options.fastOpen, sizeof(int)) == -1)
+            || (options.noDelay
+                && ::setsockopt(sfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(int)) == -1)
+            || (keepalive
+                && ::setsockopt(sfd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(int)) == -1)
+            || (options.keepIdle != 0
+                && ::setsockopt(sfd, IPPROTO_TCP, TCP_KEEPIDLE, &options.keepIdle, sizeof(int)) == -1)
+            || (options.keepInterval != 0
+                && ::setsockopt(sfd, IPPROTO_TCP, TCP_KEEPINTVL, &options.keepInterval, sizeof(int)) == -1)
+            || (options.keepCount != 0
+                && ::setsockopt(sfd, IPPROTO_TCP, TCP_KEEPCNT, &options.keepCount, sizeof(int)) == -1)
+            || (options.userTimeout != 0
+                && ::setsockopt(sfd, IPPROTO_TCP, TCP_USER_TIMEOUT, &options.userTimeout, sizeof(unsigned)) == -1)
+            || (options.receiveBuffer != 0
+                && ::setsockopt(sfd, SOL_SOCKET, SO_RCVBUF, &options.receiveBuffer, sizeof(int)) == -1)
+            || (options.sendBuffer != 0
+                && ::setsockopt(sfd, SOL_SOCKET, SO_SNDBUF, &options.sendBuffer, sizeof(int)) == -1)
+            || (options.incomingCpu >= 0
+                && ::setsockopt(sfd, SOL_SOCKET, SO_INCOMING_CPU, &options.incomingCpu, sizeof(int)) == -1)
+            || (options.notSentLowat != 0
+                && ::setsockopt(sfd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &options.notSentLowat, sizeof(unsigned)) == -1)) {
+            return -1;
+        }
+
+        return 0;
+    }
+
+    //! Turns off delayed acknowledgements until the kernel switches back to them
+    inline int endpoint_quickack(const int sfd)
+    {
+        const int on = 1;
+        return ::setsockopt(sfd, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof(int));
+    }
+
+    //! @struct socket_memory
+    /* kernel memory of a socket, in bytes (SO_MEMINFO)
+     */
+    struct socket_memory {
+
+        // Received data not yet read
+        std::uint32_t receiveQueued;
+        // Receive buffer size; the most received data the socket may hold
+        std::uint32_t receiveLimit;
+        // Sent data not yet acknowledged, and data not yet sent
+        std::uint32_t sendQueued;
+        // Send buffer size
+        std::uint32_t sendLimit;
+        // Memory reserved by the socket but not in use, and option memory
+        std::uint32_t reserved;
+    };
+
+    //! Reads the kernel memory of a socket
+    //! @param mem    [out] memory of the socket
+    inline int endpoint_memory(const int sfd, socket_memory* const mem)
+    {
+        std::uint32_t info[SK_MEMINFO_VARS] = {};
+        socklen_t size = sizeof(info);
+
+        if (::getsockopt(sfd, SOL_SOCKET, SO_MEMINFO, info, &size) == -1) {
+            return -1;
+        }
+
+        mem->receiveQueued = info[SK_MEMINFO_RMEM_ALLOC];
+        mem->receiveLimit = info[SK_MEMINFO_RCVBUF];
+        mem->sendQueued = info[SK_MEMINFO_WMEM_QUEUED];
+        mem->sendLimit = info[SK_MEMINFO_SNDBUF];
+        mem->reserved = info[SK_MEMINFO_FWD_ALLOC] + info[SK_MEMINFO_OPTMEM];
+        return 0;
+    }
+
+    //! Sets socket buffer sizes; the kernel doubles the values, capped by net.core.rmem_max and wmem_max,
+    //! and stops auto-tuning the buffers of the socket
+    //! @param receiveBuffer    SO_RCVBUF, 0 leaves the size unchanged
+    //! @param sendBuffer       SO_SNDBUF, 0 leaves the size unchanged
+    inline int endpoint_set_buffers(const int sfd, const int receiveBuffer, const int sendBuffer)
+    {
+        if ((receiveBuffer != 0 && ::setsockopt(sfd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(int)) == -1)
+            || (sendBuffer != 0 && ::setsockopt(sfd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(int)) == -1)) {
+            return -1;
+        }
+
+        return 0;
+    }
+
     inline int endpoint_tcp()
     {
         return ::socket(AF_INET, SOCK_STREAM, 0);
     }
 
-    inline int endpoint_tcp_server(const int port, const int queuelen)
+    inline int endpoint_tcp6()
     {
-        struct sockaddr_in addr = {};
+        return ::socket(AF_INET6, SOCK_STREAM, 0);
+    }
 
-        addr.sin_family = AF_INET;
-        addr.sin_port = ::htons(port);
-        addr.sin_addr.s_addr = ::htonl(INADDR_ANY);
+    inline int endpoint_unix()
+    {
+        return ::socket(AF_UNIX, SOCK_STREAM, 0);
+    }
 
+    //! Creates a listening stream socket of any address family
+    //! @param addr         local address
+    //! @param size         size of the local address
+    //! @param queuelen     backlog queue length for accept()
+    //! @param reuseport    join the SO_REUSEPORT group of the address; not supported by AF_UNIX
+    //! @param v6only       for AF_INET6, refuse IPv4-mapped connections; by default the socket is dual-stack
+    //! @param options      TCP options set before listen(), or nullptr
+    inline int endpoint_stream_server(const struct sockaddr* addr,
+                                      const socklen_t size,
+                                      const int queuelen,
+                                      const bool reuseport = false,
+                                      const bool v6only = false,
+                                      const socket_options* options = nullptr)
+    {
         int sfd;
-        if ((sfd = endpoint_tcp()) == -1) {
+        if ((sfd = ::socket(addr->sa_family, SOCK_STREAM, 0)) == -1) {
             return -1;
         }
 
         int flags = 1;
-        if (setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &flags, sizeof(int)) == -1) {
-            return -1;
+        if (addr->sa_family != AF_UNIX && setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &flags, sizeof(int)) == -1) {
+            return ::close(sfd), -1;
+        }
+
+        // Allow several listeners on the same port; the kernel load-balances connection requests between them
+        if (reuseport && setsockopt(sfd, SOL_SOCKET, SO_REUSEPORT, &flags, sizeof(int)) == -1) {
+            return ::close(sfd), -1;
+        }
+
+        // Set explicitly, the system default (net.ipv6.bindv6only) may differ
+        int only = v6only ? 1 : 0;
+        if (addr->sa_family == AF_INET6 && setsockopt(sfd, IPPROTO_IPV6, IPV6_V6ONLY, &only, sizeof(int)) == -1) {
+            return ::close(sfd), -1;
         }
 
         // Bind to local socket
-        if (bind(sfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(struct sockaddr_in)) == -1) {
+        if (bind(sfd, addr, size) == -1) {
+            return ::close(sfd), -1;
+        }
+
+        // Accepted sockets are cloned from the listener, and inherit these
+        if (options != nullptr && endpoint_set_options(sfd, *options) == -1) {
             return ::close(sfd), -1;
         }
 
@@ -46,6 +259,123 @@ namespace comm {
         return sfd;
     }
 
+    inline int endpoint_tcp_server(const int port,
+                                   const int queuelen,
+                                   const bool reuseport = false,
+                                   const socket_options* options = nullptr)
+    {
+        struct sockaddr_in addr = {};
+
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_ANY);
+
+        return endpoint_stream_server(reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr), queuelen, reuseport,
+                                      false, options);
+    }
+
+    //! Creates a listening TCP socket on a numeric IPv4 or IPv6 address
+    //! @param ipaddr    local address, e.g. "0.0.0.0", "::" (IPv4 and IPv6) or "::1"
+    inline int endpoint_tcp_server(const char* ipaddr,
+                                   const int port,
+                                   const int queuelen,
+                                   const bool reuseport = false,
+                                   const bool v6only = false,
+                                   const socket_options* options = nullptr)
+    {
+        struct sockaddr_in addr = {};
+        struct sockaddr_in6 addr6 = {};
+
+        if (::inet_pton(AF_INET, ipaddr, &addr.sin_addr) == 1)
+        {
+            addr.sin_family = AF_INET;
+            addr.sin_port = ::htons(port);
+            return endpoint_stream_server(reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr), queuelen, reuseport,
+                                          false, options);
+        }
+
+        if (::inet_pton(AF_INET6, ipaddr, &addr6.sin6_addr) == 1)
+        {
+            addr6.sin6_family = AF_INET6;
+            addr6.sin6_port = ::htons(port);
+            return endpoint_stream_server(reinterpret_cast<struct sockaddr*>(&addr6), sizeof(addr6), queuelen, reuseport,
+                                          v6only, options);
+        }
+
+        errno = EINVAL;
+        return -1;
+    }
+
+    //! Fills Unix-domain socket address
+    //! @return size of the address, 0 if the path does not fit
+    inline socklen_t endpoint_unix_address(const char* path, struct sockaddr_un* addr)
+    {
+        const std::size_t length = std::strlen(path);
+        if (length == 0 || length >= sizeof(addr->sun_path)) {
+            return errno = ENAMETOOLONG, 0;
+        }
+
+        std::memset(addr, 0, sizeof(*addr));
+        addr->sun_family = AF_UNIX;
+        std::memcpy(addr->sun_path, path, length);
+        return static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + length + 1);
+    }
+
+    //! Creates a listening Unix-domain stream socket
+    //! A stale socket file left at the path is removed; any other file is left alone and the call fails
+    //! @param path    file system path
+    inline int endpoint_unix_server(const char* path, const int queuelen)
+    {
+        struct sockaddr_un addr;
+
+        socklen_t size;
+        if ((size = endpoint_unix_address(path, &addr)) == 0) {
+            return -1;
+        }
+
+        struct stat st;
+        if (::lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+            ::unlink(path);
+        }
+
+        return endpoint_stream_server(reinterpret_cast<struct sockaddr*>(&addr), size, queuelen);
+    }
+
+    //! Creates a Unix-domain packet socket (SOCK_SEQPACKET); message boundaries are kept
+    inline int endpoint_unix_packet()
+    {
+        return ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    }
+
+    //! Creates a listening Unix-domain packet socket, for one peer at a time
+    //! A stale socket file left at the path is removed; any other file is left alone and the call fails
+    //! @param path    file system path
+    inline int endpoint_unix_packet_server(const char* path)
+    {
+        struct sockaddr_un addr;
+
+        socklen_t size;
+        if ((size = endpoint_unix_address(path, &addr)) == 0) {
+            return -1;
+        }
+
+        struct stat st;
+        if (::lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+            ::unlink(path);
+        }
+
+        int sfd;
+        if ((sfd = endpoint_unix_packet()) == -1) {
+            return -1;
+        }
+
+        if (bind(sfd, reinterpret_cast<struct sockaddr*>(&addr), size) == -1 || listen(sfd, 1) == -1) {
+            return ::close(sfd), -1;
+        }
+
+        return sfd;
+    }
+
     inline int endpoint_udp()
     {
         return ::socket(AF_INET, SOCK_DGRAM, 0);
@@ -148,6 +478,159 @@ namespace comm {
         return ::connect(sfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(struct sockaddr_in));
     }
 
+    //! Connects IPv6 socket
+    //! @param ipaddr    numeric IPv6 address
+    inline int endpoint_connect6(const int sfd,
+                                 const char* ipaddr,
+                                 const int port)
+    {
+        struct sockaddr_in6 addr = {};
+
+        if (::inet_pton(AF_INET6, ipaddr, &addr.sin6_addr) != 1) {
+            return errno = EINVAL, -1;
+        }
+
+        addr.sin6_port = ::htons(port);
+        addr.sin6_family = AF_INET6;
+
+        return ::connect(sfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(struct sockaddr_in6));
+    }
+
+    //! Connects Unix-domain socket
+    //! @param path    file system path of the listening socket
+    inline int endpoint_connect_unix(const int sfd, const char* path)
+    {
+        struct sockaddr_un addr;
+
+        socklen_t size;
+        if ((size = endpoint_unix_address(path, &addr)) == 0) {
+            return -1;
+        }
+
+        return ::connect(sfd, reinterpret_cast<struct sockaddr*>(&addr), size);
+    }
+
+    //! Sends a message along with open descriptors (SCM_RIGHTS) over a Unix-domain socket;
+    //! the receiving process gets its own descriptors to the same open files
+    //! @param fds        descriptors to send, at most SCM_MAX_FD (253)
+    //! @param count      number of descriptors
+    //! @param data       message, at least one byte
+    //! @param datalen    message length
+    //! @return           number of bytes sent, -1 on error
+    inline int endpoint_send_fds(const int sfd,
+                                 const int* const fds,
+                                 const int count,
+                                 const void* const data,
+                                 const int datalen)
+    {
+        struct iovec iov;
+        iov.iov_base = const_cast<void*>(data);
+        iov.iov_len = datalen;
+
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        // Control buffer, aligned for cmsghdr
+        union {
+            char buff[CMSG_SPACE(sizeof(int) * 253)];
+            struct cmsghdr align;
+        } control;
+
+        if (count > 0)
+        {
+            if (count > 253) {
+                return errno = EINVAL, -1;
+            }
+
+            msg.msg_control = control.buff;
+            msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+            std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+        }
+
+        return ::sendmsg(sfd, &msg, MSG_NOSIGNAL);
+    }
+
+    //! Receives a message sent by endpoint_send_fds(); received descriptors are close-on-exec
+    //! @param fds         [out] received descriptors
+    //! @param count       [out] number of received descriptors
+    //! @param maxcount    size of fds; if more descriptors arrive, they are closed and the call fails
+    //! @param data        [out] message
+    //! @param datalen     size of data; a longer message fails the call
+    //! @return            number of bytes received, 0 if the peer closed the socket, -1 on error
+    inline int endpoint_receive_fds(const int sfd,
+                                    int* const fds,
+                                    int* const count,
+                                    const int maxcount,
+                                    void* const data,
+                                    const int datalen)
+    {
+        struct iovec iov;
+        iov.iov_base = data;
+        iov.iov_len = datalen;
+
+        union {
+            char buff[CMSG_SPACE(sizeof(int) * 253)];
+            struct cmsghdr align;
+        } control;
+
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buff;
+        msg.msg_controllen = sizeof(control.buff);
+
+        *count = 0;
+
+        int ret;
+        if ((ret = ::recvmsg(sfd, &msg, MSG_CMSG_CLOEXEC)) == -1) {
+            return -1;
+        }
+
+        bool fits = (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) == 0;
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+
+            const int received = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            for (int i = 0; i != received; ++i)
+            {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(cmsg) + sizeof(int) * i, sizeof(int));
+
+                if (*count < maxcount) {
+                    fds[(*count)++] = fd;
+                }
+
+                else
+                {
+                    ::close(fd);
+                    fits = false;
+                }
+            }
+        }
+
+        // Descriptors of a partial message are not handed out
+        if (!fits)
+        {
+            for (int i = 0; i != *count; ++i) {
+                ::close(fds[i]);
+            }
+
+            *count = 0;
+            return errno = EMSGSIZE, -1;
+        }
+
+        return ret;
+    }
+
     inline int endpoint_unblock(const int sfd)
     {
         int flags = ::fcntl(sfd, F_GETFL, 0);
@@ -161,11 +644,41 @@ namespace comm {
 
     inline int endpoint_accept(const int sfd)
     {
-        struct sockaddr_in addr = {};
-        socklen_t size = sizeof(struct sockaddr_in);
+        struct sockaddr_storage addr = {};
+        socklen_t size = sizeof(struct sockaddr_storage);
 
         return ::accept(sfd, reinterpret_cast<struct sockaddr*>(&addr), &size);
     }
+
+    //! Accepts connection; the new socket is non-blocking and close-on-exec, with no additional syscalls
+    inline int endpoint_accept_nonblock(const int sfd)
+    {
+        return ::accept4(sfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    }
+
+    //! Accepts connection as above, and stores the peer address
+    //! @param addr    [out] peer address
+    inline int endpoint_accept_nonblock(const int sfd, struct sockaddr_storage* const addr)
+    {
+        socklen_t size = sizeof(struct sockaddr_storage);
+        return ::accept4(sfd, reinterpret_cast<struct sockaddr*>(addr), &size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    }
+
+    //! Attaches a classic BPF program to the SO_REUSEPORT group of a listener, which hands each connection
+    //! to the listener at index (receiving CPU % group size); listeners are indexed in the order they were bound
+    //! @param sfd          any listener of the group, once every listener is bound
+    //! @param groupSize    number of listeners in the group
+    inline int endpoint_reuseport_by_cpu(const int sfd, const unsigned groupSize)
+    {
+        struct sock_filter code[] = {
+            { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU) }, // A = CPU
+            { BPF_ALU | BPF_MOD | BPF_K, 0, 0, groupSize }, // A = A % group size
+            { BPF_RET | BPF_A, 0, 0, 0 } // Return A
+        };
+
+        struct sock_fprog prog = { sizeof(code) / sizeof(code[0]), code };
+        return ::setsockopt(sfd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+    }
 }
 
 #endif
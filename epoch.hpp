@@ -0,0 +1,291 @@
+/* epoch.hpp -- v1.0 -- quiescent-state based reclamation of read-mostly shared objects
+   Author: Sam Y. 2026
+
+   Readers are registered threads that announce, now and then, that they hold no shared object: a quiescent point.
+   A writer replaces an object, then retires the old version; it is deleted once every registered thread has passed
+   a quiescent point, as none can still be reading it. Reads take one atomic load, and no read-modify-write. */
+
+#ifndef _COMM_EPOCH_HPP
+#define _COMM_EPOCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace comm {
+
+    //! @class epoch_domain
+    /*! registered threads and retired objects; the epoch advances on every retirement, and an object retired in
+     *! epoch e is deleted once every registered thread has seen an epoch after e at a quiescent point
+     */
+    class epoch_domain {
+    public:
+
+        //! @struct participant
+        /* registered thread
+         */
+        struct participant {
+
+            // Epoch seen at the latest quiescent point, 0 while the thread holds no shared object for long
+            std::atomic<std::uint64_t> seen;
+            participant* next;
+            bool joined;
+            // Readers only write their own record
+            char pad[64 - sizeof(std::atomic<std::uint64_t>) - sizeof(participant*) - sizeof(bool)];
+
+            //! ctor.
+            participant() : seen(0), next(nullptr), joined(false) {}
+        };
+
+        //! dtor.
+        //! No thread may still be registered
+        ~epoch_domain() {
+
+            for (std::size_t i = 0; i != retired_.size(); ++i) {
+                retired_[i].deleter(retired_[i].ptr);
+            }
+
+            while (participants_ != nullptr)
+            {
+                participant* next = participants_->next;
+                delete participants_;
+                participants_ = next;
+            }
+        }
+
+        //! ctor.
+        //!
+        epoch_domain() : epoch_(1), participants_(nullptr) {}
+
+        //! @get
+        //! @return number of retired objects not yet deleted
+        std::size_t get_retired_count() const {
+
+            std::lock_guard<std::mutex> lock(lock_);
+            return retired_.size();
+        }
+
+        //! Registers calling thread as a reader
+        //! @return record passed to quiescent() and leave()
+        participant* join() {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            participant* p = participants_;
+            while (p != nullptr && p->joined) {
+                p = p->next;
+            }
+
+            if (p == nullptr)
+            {
+                p = new participant;
+                p->next = participants_;
+                participants_ = p;
+            }
+
+            p->joined = true;
+            online(*p);
+            return p;
+        }
+
+        //! Unregisters reader; it may not hold shared objects anymore
+        //! @param p    record returned by join()
+        void leave(participant* p) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            p->seen.store(0, std::memory_order_release);
+            p->joined = false;
+        }
+
+        //! Announces that the reader holds no shared object; wait-free
+        //! Pointers loaded before this call may not be used after it
+        //! @param p    record returned by join()
+        void quiescent(participant& p) {
+
+            // Nothing was retired since the previous call, which is then still current
+            const std::uint64_t epoch = epoch_.load(std::memory_order_acquire);
+            if (p.seen.load(std::memory_order_relaxed) != epoch) {
+                p.seen.store(epoch, std::memory_order_release);
+            }
+        }
+
+        //! Announces that the reader holds no shared object until online() is called, e.g. before it blocks;
+        //! objects are reclaimed meanwhile
+        //! @param p    record returned by join()
+        void offline(participant& p) {
+
+            p.seen.store(0, std::memory_order_release);
+        }
+
+        //! Ends offline()
+        //! @param p    record returned by join()
+        void online(participant& p) {
+
+            p.seen.store(epoch_.load());
+
+            // Loads that follow see every object unlinked before a reclaimer misses this store
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        //! Deletes object once no reader can hold it; the object must not be reachable by readers anymore
+        //! @param ptr    object allocated with new
+        template <typename T>
+        void retire(T* ptr) {
+
+            retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+        }
+
+        //! Deletes object with deleter once no reader can hold it
+        //! @param ptr        object
+        //! @param deleter    function taking ptr
+        void retire(void* ptr, void (*deleter)(void*)) {
+
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+
+                // Readers that see the next epoch at a quiescent point are past their last read of the object
+                retired r = { ptr, deleter, epoch_.fetch_add(1) };
+                retired_.push_back(r);
+            }
+
+            reclaim();
+        }
+
+        //! Deletes retired objects that no reader can hold anymore
+        //! @return true if no retired object is left
+        bool reclaim() {
+
+            std::vector<retired> expired;
+            bool empty;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+
+                std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+                for (participant* p = participants_; p != nullptr; p = p->next)
+                {
+                    const std::uint64_t seen = p->seen.load();
+                    if (seen != 0 && seen < oldest) {
+                        oldest = seen;
+                    }
+                }
+
+                // Retired in epoch order
+                std::size_t count = 0;
+                while (count != retired_.size() && retired_[count].epoch < oldest) {
+                    ++count;
+                }
+
+                expired.assign(retired_.begin(), retired_.begin() + count);
+                retired_.erase(retired_.begin(), retired_.begin() + count);
+                empty = retired_.empty();
+            }
+
+            // Deleters may retire objects themselves
+            for (std::size_t i = 0; i != expired.size(); ++i) {
+                expired[i].deleter(expired[i].ptr);
+            }
+
+            return empty;
+        }
+
+        //! Waits until every object retired so far is deleted; may not be called by a registered thread
+        //!
+        void synchronize() {
+
+            while (!reclaim()) {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+
+        // Object waiting for its grace period
+        struct retired {
+            void* ptr;
+            void (*deleter)(void*);
+            std::uint64_t epoch;
+        };
+
+        std::atomic<std::uint64_t> epoch_; // Current epoch, starts at 1
+        participant* participants_; // Registered and former readers; records are reused
+        std::vector<retired> retired_;
+        mutable std::mutex lock_; // Applied to registration and retirement; never taken by readers
+
+        // Non-copyable object
+        explicit epoch_domain(epoch_domain&) = delete;
+        explicit epoch_domain(const epoch_domain&) = delete;
+    };
+
+    //! @class rcu_ptr
+    /*! pointer to a read-mostly object; readers load the current version, writers publish a new one and retire
+     *! the old one to the domain
+     */
+    template <typename T>
+    class rcu_ptr {
+    public:
+
+        //! dtor.
+        //! No reader may still hold the current version
+        ~rcu_ptr() {
+            delete ptr_.load();
+        }
+
+        //! ctor.
+        //! @param domain     domain that retired versions are passed to
+        //! @param initial    first version, allocated with new; may be nullptr
+        explicit rcu_ptr(epoch_domain& domain, T* initial = nullptr) : domain_(domain), ptr_(initial) {}
+
+        //! Returns current version; wait-free
+        //! Only valid on a thread registered with the domain, until its next quiescent point
+        const T* load() const {
+            return ptr_.load(std::memory_order_acquire);
+        }
+
+        //! Publishes new version, and retires the previous one
+        //! @param next    new version, allocated with new
+        void store(T* next) {
+
+            T* previous = ptr_.exchange(next);
+            if (previous != nullptr) {
+                domain_.retire(previous);
+            }
+        }
+
+        //! Publishes a modified copy of the current version, and retires the current one; writers are serialized
+        //! @param modify    callable taking (T&), applied to the copy; the current version must not be nullptr
+        template <typename F>
+        void update(F modify) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            T* next = new T(*ptr_.load(std::memory_order_acquire));
+            try {
+                modify(*next);
+            }
+
+            catch (...)
+            {
+                delete next;
+                throw;
+            }
+
+            store(next);
+        }
+
+    private:
+
+        epoch_domain& domain_;
+        std::atomic<T*> ptr_;
+        std::mutex lock_; // Serializes update()
+
+        // Non-copyable object
+        explicit rcu_ptr(rcu_ptr&) = delete;
+        explicit rcu_ptr(const rcu_ptr&) = delete;
+    };
+}
+
+#endif
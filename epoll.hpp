@@ -2,7 +2,22 @@
    Author: Sam Y. 2021 
 
    epoll.hpp -- v1.1
-   Modified: Class now keeps track of multiple readers that are using the same epoll descriptor, 2023 */
+   Modified: Class now keeps track of multiple readers that are using the same epoll descriptor, 2023
+
+   epoll.hpp -- v1.2
+   Modified: Derived class is notified of every poll, with the number of events returned
+
+   epoll.hpp -- v1.3
+   Modified: One waiting thread at a time can be retired through the self-pipe
+
+   epoll.hpp -- v1.4
+   Modified: Descriptors other than clients and listeners can be watched under a reserved id
+
+   epoll.hpp -- v1.5
+   Modified: Client descriptors can be watched level-triggered
+
+   epoll.hpp -- v1.6
+   Modified: Server descriptors carry a tag in the upper word of their event data */
 
 #ifndef _COMM_EPOLL_HPP
 #define _COMM_EPOLL_HPP
@@ -11,6 +26,7 @@
 
 #include "client.hpp"
 #include "endpoint.hpp"
+#include "mem.hpp"
 
 namespace comm {
 
@@ -35,6 +51,22 @@ namespace comm {
             return ret;
         }
 
+        /*! Helper, implements epoll_ctl()
+         */
+        inline int ctl(const int epfd,
+                       const int opcode,
+                       const int sfd,
+                       const int events,
+                       const std::uint64_t userdata)
+        {
+            ::epoll_event epollEvent = {};
+            epollEvent.events = events;
+            epollEvent.data.u64 = userdata;
+
+            const int ret = epoll_ctl(epfd, opcode, sfd, &epollEvent);
+            return ret;
+        }
+
         /*! Helper, implements epoll_ctl()
          */
         inline int ctl(const int epfd,
@@ -67,10 +99,19 @@ namespace comm {
             endpoint_close(selfpipe_[1]);
         }
 
+        //! ctor.
+        //! @param resource    memory resource used for event arrays
+        //!
+        explicit epoll(memory_resource* resource) : epoll(DEFAULT_MAX_EVENTS, resource) {}
+
         //! ctor.
         //! @param maxevents    maximum number of epoll to read before calling event handler
+        //! @param resource     memory resource used for event arrays
         //!
-        epoll(const int maxevents = DEFAULT_MAX_EVENTS) : maxevents_(maxevents) {
+        epoll(const int maxevents = DEFAULT_MAX_EVENTS,
+              memory_resource* resource = get_heap_resource()) : maxevents_(maxevents)
+                                                               , clientEvents_(CLIENT_EVENTS)
+                                                               , resource_(resource) {
 
             // Generate epoll instance
             if ((epfd_ = epoll_create1(0)) == -1) {
@@ -104,11 +145,13 @@ namespace comm {
 
         //! Adds managed server socket
         //! @param sfd    socket file descriptor
+        //! @param tag    passed back on events, in the upper word of the event data; sfd is in the lower word
         template <typename Q = Tderiv>
         typename std::enable_if<std::is_base_of<server_pool_base, Q>::value,
-                                int>::type add(int sfd) {
+                                int>::type add(int sfd, const std::uint32_t tag = 0) {
             const int events = EPOLLIN | EPOLLET | EPOLLEXCLUSIVE;
-            const int ret = detail::ctl(epfd_, EPOLL_CTL_ADD, sfd, events, sfd);
+            const std::uint64_t userdata = (static_cast<std::uint64_t>(tag) << 32) | static_cast<std::uint32_t>(sfd);
+            const int ret = detail::ctl(epfd_, EPOLL_CTL_ADD, sfd, events, userdata);
             return ret;
         }
 
@@ -117,8 +160,7 @@ namespace comm {
         template <typename Q = Tderiv>
         typename std::enable_if<std::is_base_of<client_pool_base, Q>::value,
                                 int>::type add(client* handler) {
-            const int events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLPRI | EPOLLONESHOT;
-            const int ret = detail::ctl(epfd_, EPOLL_CTL_ADD, handler->sfd, events, handler);
+            const int ret = detail::ctl(epfd_, EPOLL_CTL_ADD, handler->sfd, clientEvents_, handler->get_handle().id);
             return ret;
         }
 
@@ -127,8 +169,22 @@ namespace comm {
         template <typename Q = Tderiv>
         typename std::enable_if<std::is_base_of<client_pool_base, Q>::value,
                                 int>::type rearm(client* handler) {
-            const int events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLPRI | EPOLLONESHOT;
-            const int ret = detail::ctl(epfd_, EPOLL_CTL_MOD, handler->sfd, events, handler);
+            const int ret = detail::ctl(epfd_, EPOLL_CTL_MOD, handler->sfd, clientEvents_, handler->get_handle().id);
+            return ret;
+        }
+
+        //! Watches client descriptors added or rearmed from now on level-triggered, rather than edge-triggered;
+        //! either way, each event is reported to one thread, until the descriptor is rearmed
+        //! @param level    true for level-triggered
+        void set_level_triggered(const bool level) {
+            clientEvents_ = level ? static_cast<int>(CLIENT_EVENTS & ~EPOLLET) : CLIENT_EVENTS;
+        }
+
+        //! Adds descriptor that is neither a client nor a listener, such as an eventfd; edge-triggered, for reading
+        //! @param fd    file descriptor
+        //! @param id    value passed to the derived class on events; 0 is reserved for the self-pipe
+        int watch(const int fd, const std::uint64_t id) {
+            const int ret = detail::ctl(epfd_, EPOLL_CTL_ADD, fd, EPOLLIN | EPOLLET, id);
             return ret;
         }
 
@@ -143,13 +199,25 @@ namespace comm {
         //! Signals shut down by writing to pipe
         //!
         void close() {
-            char ch = '$';
+            char ch = SHUTDOWN;
+            endpoint_write(selfpipe_[0], &ch, sizeof(ch));
+        }
+
+        //! Signals one waiting thread to return, once it has processed the events of its last poll
+        //!
+        void retire() {
+            char ch = RETIRE;
             endpoint_write(selfpipe_[0], &ch, sizeof(ch));
         }
 
     private:
 
         static const int DEFAULT_MAX_EVENTS = 65536;
+        static const int CLIENT_EVENTS = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLPRI | EPOLLONESHOT;
+
+        // Control messages
+        static const char SHUTDOWN = '$';
+        static const char RETIRE = '-';
 
         // Pipe used to send control signals; signals close
         int selfpipe_[2];
@@ -157,6 +225,10 @@ namespace comm {
         int epfd_;
         // Epoll parameter
         int maxevents_;
+        // Events client descriptors are watched for
+        int clientEvents_;
+        // Event array allocation
+        memory_resource* resource_;
 
         // Non-copyable object
         explicit epoll(epoll&) = delete;
@@ -173,26 +245,51 @@ namespace comm {
         const int epfd = epfd_;
         const int maxevents = maxevents_;
 
-        epoll_event* const events = new epoll_event[maxevents];
+        epoll_event* const events = static_cast<epoll_event*>(resource_->allocate(sizeof(epoll_event) * maxevents,
+                                                                                  alignof(epoll_event)));
 
-        while (true)
+        bool retiring = false;
+        while (!retiring)
         {
             int nevents;
             if ((nevents = epoll_wait(epfd, events, maxevents, 0)) == -1) {
                 break; // Encountered error
             }
 
+            static_cast<Tderiv*>(this)->on_wait(nevents);
+
             for (int i = 0; i != nevents; ++i)
             {
+                // Warm up the next event's record while this one is dispatched
+                if (i + 1 != nevents) {
+                    static_cast<Tderiv*>(this)->prefetch(events[i + 1].data);
+                }
+
                 // If have a control socket, process message
-                // As of now, the only control message is to exit the wait instance
-                if (events[i].data.ptr == nullptr)
+                // Control messages either exit every wait instance, or retire this one
+                if (events[i].data.u64 == 0)
                 {
-                    delete[] events;
-
                     char ch;
                     endpoint_read(selfpipe_[1], &ch, sizeof(ch));
 
+                    // Only this thread exits; the rest of its events are processed first, as one-shot descriptors
+                    // would not be signalled again. Rearming lets another thread read any further message.
+                    if (ch == RETIRE)
+                    {
+                        if (detail::ctl(epfd_, EPOLL_CTL_MOD, selfpipe_[1], EPOLLIN | EPOLLET | EPOLLONESHOT,
+                                        nullptr) == -1)
+                        {
+                            perror("epoll::wait");
+                            throw std::runtime_error("ctl failed on self pipe");
+                        }
+
+                        --runningInstances;
+                        retiring = true;
+                        continue;
+                    }
+
+                    resource_->deallocate(events, sizeof(epoll_event) * maxevents, alignof(epoll_event));
+
                     // Daisy-chained shutdown using the self-pipe trick.
                     // Before escaping the current thread, this block will write to the self-pipe. The next
                     // thread to call epoll_wait() will read the pipe and follow the same daisy-chained exit procedure.
@@ -207,7 +304,7 @@ namespace comm {
                     {
                         if (--runningInstances > 0)
                         {
-                            char ch = '$';
+                            char ch = SHUTDOWN;
                             endpoint_write(selfpipe_[0], &ch, sizeof(ch));
                         }
                     }
@@ -223,6 +320,8 @@ namespace comm {
                 }
             }
         }
+
+        resource_->deallocate(events, sizeof(epoll_event) * maxevents, alignof(epoll_event));
     }
 }
 
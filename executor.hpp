@@ -0,0 +1,175 @@
+/* executor.hpp -- v1.0 -- compute thread pool, fed through a bounded lock-free queue
+   Author: Sam Y. 2026 */
+
+#ifndef _COMM_EXECUTOR_HPP
+#define _COMM_EXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mem.hpp"
+#include "mpmc_queue.hpp"
+
+namespace comm {
+
+    //! @class executor
+    /*! runs tasks on a separate pool of threads, so that CPU-heavy work does not hold up the I/O workers
+     *! idle threads spin briefly on the queue, then sleep until the next task is submitted
+     */
+    class executor {
+    public:
+
+        typedef std::function<void()> task;
+
+        //! dtor.
+        //!
+        ~executor() {
+            stop();
+        }
+
+        //! ctor.
+        //! @param threadCount    number of compute threads
+        //! @param capacity       maximum number of queued tasks, rounded up to a power of two
+        //! @param resource       memory resource used for the queue
+        executor(const std::size_t threadCount,
+                 const std::size_t capacity,
+                 memory_resource* resource = get_heap_resource()) : queue_(capacity, resource)
+                                                                  , threadCount_(threadCount)
+                                                                  , stopping_(false)
+                                                                  , sleeping_(0) {}
+
+        //! @get
+        //! @return number of compute threads
+        std::size_t get_thread_count() const {
+            return threadCount_;
+        }
+
+        //! @get
+        //! @return number of queued tasks; approximate
+        std::size_t get_queued_count() const {
+            return queue_.get_size();
+        }
+
+        //! Queues task; tasks may be submitted before run()
+        //! A task that throws is abandoned; the exception is dropped, and the thread goes on with the next task
+        //! @return false if the queue is full
+        bool submit(task t) {
+
+            if (!queue_.push(std::move(t))) {
+                return false;
+            }
+
+            // Pairs with the fence of a thread going to sleep: either it sees the task, or this sees it counted
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping_.load() != 0)
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                wake_.notify_one();
+            }
+
+            return true;
+        }
+
+        //! Starts compute threads
+        //!
+        void run() {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (threads_.empty())
+            {
+                stopping_ = false;
+                for (std::size_t i = 0; i != threadCount_; ++i) {
+                    threads_.emplace_back(&executor::work, this);
+                }
+            }
+        }
+
+        //! Stops compute threads, once every queued task has run
+        //!
+        void stop() {
+
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+
+                stopping_ = true;
+                threads.swap(threads_);
+                wake_.notify_all();
+            }
+
+            for (std::size_t i = 0; i != threads.size(); ++i) {
+                threads[i].join();
+            }
+        }
+
+    private:
+
+        // Failed pops before a thread goes to sleep
+        static const int SPIN_COUNT = 256;
+
+        /*! Compute thread
+         */
+        void work() {
+
+            task t;
+            int spins = 0;
+            while (true)
+            {
+                if (queue_.pop(t))
+                {
+                    try {
+                        t();
+                    }
+
+                    catch (...) {}
+
+                    t = nullptr;
+                    spins = 0;
+                    continue;
+                }
+
+                if (++spins < SPIN_COUNT)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(lock_);
+
+                // A task submitted after this increment finds the thread counted, and wakes it
+                ++sleeping_;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (queue_.get_size() == 0 && !stopping_) {
+                    wake_.wait(lock);
+                }
+                --sleeping_;
+
+                if (stopping_ && queue_.get_size() == 0) {
+                    return;
+                }
+
+                spins = 0;
+            }
+        }
+
+        mpmc_queue<task>         queue_;
+        std::size_t              threadCount_;
+        std::vector<std::thread> threads_;
+
+        bool                     stopping_;
+        std::atomic<std::size_t> sleeping_; // # of threads waiting for a task
+        std::mutex               lock_;
+        std::condition_variable  wake_;
+
+        // Non-copyable object
+        explicit executor(executor&) = delete;
+        explicit executor(const executor&) = delete;
+    };
+}
+
+#endif
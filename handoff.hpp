@@ -0,0 +1,360 @@
+/* handoff.hpp -- v1.0 -- passes listeners and live connections to another process
+   Author: Sam Y. 2026
+
+   Used to restart a server without dropping connections. The new process listens on a Unix-domain packet socket,
+   and the old process connects to it and sends:
+   - LISTENERS messages: listener descriptors, with one handoff_listener record each
+   - CLIENTS messages: connection descriptors, with one handoff_client record each, followed by the state the
+     handler exported for the connection
+   - one END message
+   Every message starts with a handoff_header; descriptors are attached to their message (SCM_RIGHTS). Records are
+   copied as is, so both processes must be built from the same version of this file. */
+
+#ifndef _COMM_HANDOFF_HPP
+#define _COMM_HANDOFF_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "client.hpp"
+#include "endpoint.hpp"
+
+namespace comm {
+
+    //! @struct handoff_header
+    /* first bytes of every handoff message
+     */
+    struct handoff_header {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t kind;
+        // Number of records, equal to the number of attached descriptors
+        std::uint32_t count;
+        // Bytes following the header
+        std::uint32_t size;
+    };
+
+    //! @struct handoff_listener
+    /* listener record
+     */
+    struct handoff_listener {
+
+        enum : std::uint32_t {
+            QUICK_ACK = 1, // Accepted connections are set to TCP_QUICKACK
+            STEERING = 2 // The listener group steers connections by CPU
+        };
+
+        std::uint32_t flags;
+        // Index of the acceptor that waits on the listener, -1 if every acceptor does
+        std::int32_t acceptor;
+    };
+
+    //! @struct handoff_client
+    /* connection record, followed by stateSize bytes of state, padded to 8 bytes
+     */
+    struct handoff_client {
+        peer_address peer;
+        std::uint64_t received;
+        std::uint32_t stateSize;
+        std::uint32_t reserved;
+    };
+
+    //! @class handoff_channel
+    /*! one end of a handoff; the sending end buffers records and sends them in batches
+     */
+    class handoff_channel {
+    public:
+
+        static const std::uint32_t MAGIC = 0x48414e44; // "HAND"
+        static const std::uint16_t VERSION = 1;
+
+        // Message kinds
+        enum : std::uint16_t {
+            LISTENERS = 1,
+            CLIENTS = 2,
+            END = 3
+        };
+
+        // Descriptors per message
+        static const int MAX_FDS = 64;
+        // Bytes per message; kept below the default socket send buffer
+        static const std::size_t MAX_MESSAGE = 65536;
+        // Bytes of exported state per connection
+        static const std::size_t MAX_STATE = MAX_MESSAGE - sizeof(handoff_header) - sizeof(handoff_client);
+
+        //! dtor.
+        //!
+        ~handoff_channel() {
+
+            discard();
+
+            if (sfd_ != -1) {
+                endpoint_close(sfd_);
+            }
+        }
+
+        //! ctor.
+        //!
+        handoff_channel() : sfd_(-1), kind_(0) {}
+
+        //! Connects to the process taking over
+        //! @param path    file system path of the listening socket
+        bool connect(const char* path) {
+
+            if ((sfd_ = endpoint_unix_packet()) == -1) {
+                return false;
+            }
+
+            if (endpoint_connect_unix(sfd_, path) == -1)
+            {
+                endpoint_close(sfd_);
+                sfd_ = -1;
+                return false;
+            }
+
+            return true;
+        }
+
+        //! Waits for the process handing off to connect; the socket file is removed once it has
+        //! @param path       file system path of the listening socket
+        //! @param timeout    milliseconds to wait, -1 waits indefinitely
+        bool accept(const char* path, const int timeout) {
+
+            int lfd;
+            if ((lfd = endpoint_unix_packet_server(path)) == -1) {
+                return false;
+            }
+
+            struct pollfd pfd = { lfd, POLLIN, 0 };
+            if (::poll(&pfd, 1, timeout) == 1) {
+                sfd_ = ::accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+            }
+
+            ::unlink(path);
+            endpoint_close(lfd);
+            return sfd_ != -1;
+        }
+
+        //! Queues listener
+        //! @param fd          listener descriptor; the channel sends a duplicate, the caller keeps fd
+        //! @param flags       see handoff_listener
+        //! @param acceptor    index of the acceptor that waits on the listener, -1 if every acceptor does
+        bool add_listener(const int fd, const std::uint32_t flags, const int acceptor) {
+
+            handoff_listener record;
+            record.flags = flags;
+            record.acceptor = acceptor;
+            return add(LISTENERS, fd, &record, sizeof(record), nullptr, 0);
+        }
+
+        //! Queues connection
+        //! @param fd          connection descriptor; the channel sends a duplicate, the caller keeps fd
+        //! @param peer        peer address
+        //! @param received    total bytes received
+        //! @param state       exported state, at most MAX_STATE bytes
+        bool add_client(const int fd, const peer_address& peer, const std::uint64_t received, const std::string& state) {
+
+            if (state.size() > MAX_STATE) {
+                return false;
+            }
+
+            handoff_client record;
+            record.peer = peer;
+            record.received = received;
+            record.stateSize = static_cast<std::uint32_t>(state.size());
+            record.reserved = 0;
+            return add(CLIENTS, fd, &record, sizeof(record), state.data(), state.size());
+        }
+
+        //! Sends queued records, then the end of the handoff
+        //!
+        bool finish() {
+
+            if (!flush()) {
+                return false;
+            }
+
+            kind_ = END;
+            buffer_.assign(sizeof(handoff_header), '\0');
+            return flush();
+        }
+
+        //! Receives records until the end of the handoff
+        //! Descriptors are passed to the callbacks, which take ownership
+        //! @param onListener    callable taking (int fd, std::uint32_t flags, int acceptor)
+        //! @param onClient      callable taking (int fd, const peer_address&, std::uint64_t received,
+        //!                      const char* state, std::size_t stateSize)
+        //! @return              true once the end is received, false on error or if the peer closed early
+        template <typename L, typename C>
+        bool receive(L onListener, C onClient) {
+
+            std::vector<char> message(MAX_MESSAGE);
+            int fds[MAX_FDS];
+
+            while (true)
+            {
+                int count;
+                const int size = endpoint_receive_fds(sfd_, fds, &count, MAX_FDS, message.data(), static_cast<int>(message.size()));
+                if (size <= 0) {
+                    return false;
+                }
+
+                handoff_header header;
+                std::memcpy(&header, message.data(), std::min(sizeof(header), static_cast<std::size_t>(size)));
+
+                if (static_cast<std::size_t>(size) < sizeof(header)
+                    || header.magic != MAGIC
+                    || header.version != VERSION
+                    || header.count != static_cast<std::uint32_t>(count)
+                    || header.size != size - sizeof(header))
+                {
+                    close_all(fds, 0, count);
+                    return false;
+                }
+
+                if (header.kind == END) {
+                    return true;
+                }
+
+                std::size_t offset = sizeof(header);
+                for (int i = 0; i != count; ++i)
+                {
+                    if (header.kind == LISTENERS && offset + sizeof(handoff_listener) <= static_cast<std::size_t>(size))
+                    {
+                        handoff_listener record;
+                        std::memcpy(&record, message.data() + offset, sizeof(record));
+                        offset += sizeof(record);
+                        onListener(fds[i], record.flags, static_cast<int>(record.acceptor));
+                    }
+
+                    else if (header.kind == CLIENTS && offset + sizeof(handoff_client) <= static_cast<std::size_t>(size))
+                    {
+                        handoff_client record;
+                        std::memcpy(&record, message.data() + offset, sizeof(record));
+                        offset += sizeof(record);
+
+                        if (offset + record.stateSize > static_cast<std::size_t>(size))
+                        {
+                            close_all(fds, i, count);
+                            return false;
+                        }
+
+                        onClient(fds[i], record.peer, record.received, message.data() + offset, record.stateSize);
+                        offset += padded(record.stateSize);
+                    }
+
+                    else
+                    {
+                        close_all(fds, i, count);
+                        return false;
+                    }
+                }
+            }
+        }
+
+    private:
+
+        int sfd_;
+        // Message being filled
+        std::uint16_t kind_;
+        std::string buffer_;
+        std::vector<int> fds_; // Duplicates of the queued descriptors
+
+        /*! Rounds record size up to 8 bytes
+         */
+        static std::size_t padded(const std::size_t size) {
+            return (size + 7) & ~static_cast<std::size_t>(7);
+        }
+
+        /*! Closes descriptors [first, last)
+         */
+        static void close_all(const int* fds, const int first, const int last) {
+
+            for (int i = first; i < last; ++i) {
+                endpoint_close(fds[i]);
+            }
+        }
+
+        /*! Appends record to the message being filled, sending it first if the record does not fit
+         */
+        bool add(const std::uint16_t kind,
+                 const int fd,
+                 const void* record,
+                 const std::size_t size,
+                 const char* extra,
+                 const std::size_t extraSize) {
+
+            const std::size_t total = size + padded(extraSize);
+            if (!buffer_.empty()
+                && (kind != kind_ || fds_.size() == static_cast<std::size_t>(MAX_FDS) || buffer_.size() + total > MAX_MESSAGE)
+                && !flush()) {
+                return false;
+            }
+
+            int dup;
+            if ((dup = ::fcntl(fd, F_DUPFD_CLOEXEC, 0)) == -1) {
+                return false;
+            }
+
+            if (buffer_.empty())
+            {
+                kind_ = kind;
+                buffer_.assign(sizeof(handoff_header), '\0');
+            }
+
+            buffer_.append(static_cast<const char*>(record), size);
+            buffer_.append(extra != nullptr ? extra : "", extraSize);
+            buffer_.append(padded(extraSize) - extraSize, '\0');
+            fds_.push_back(dup);
+            return true;
+        }
+
+        /*! Sends the message being filled; the duplicates are closed either way
+         */
+        bool flush() {
+
+            if (buffer_.empty()) {
+                return true;
+            }
+
+            handoff_header header;
+            header.magic = MAGIC;
+            header.version = VERSION;
+            header.kind = kind_;
+            header.count = static_cast<std::uint32_t>(fds_.size());
+            header.size = static_cast<std::uint32_t>(buffer_.size() - sizeof(header));
+            buffer_.replace(0, sizeof(header), reinterpret_cast<const char*>(&header), sizeof(header));
+
+            const bool ret = sfd_ != -1
+                && endpoint_send_fds(sfd_, fds_.data(), static_cast<int>(fds_.size()), buffer_.data(),
+                                     static_cast<int>(buffer_.size())) == static_cast<int>(buffer_.size());
+
+            discard();
+            return ret;
+        }
+
+        /*! Drops the message being filled
+         */
+        void discard() {
+
+            for (std::size_t i = 0; i != fds_.size(); ++i) {
+                endpoint_close(fds_[i]);
+            }
+
+            fds_.clear();
+            buffer_.clear();
+        }
+
+        // Non-copyable object
+        explicit handoff_channel(handoff_channel&) = delete;
+        explicit handoff_channel(const handoff_channel&) = delete;
+    };
+}
+
+#endif
@@ -1,10 +1,21 @@
 /* mem.hpp -- v1.1 -- linux memmap allocation / deallocation
-   Author: Sam Y. 2023 */
+   Author: Sam Y. 2023
+
+   mem.hpp -- v1.2
+   Modified: Added polymorphic memory resources, used by the pools for all of their large allocations */
 
 #ifndef _COMM_MEM_HPP
 #define _COMM_MEM_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
 #include <cstring>
+#include <new>
+
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
 
 #include <unistd.h>
 
@@ -41,7 +52,18 @@ namespace comm {
 
             // Allocate memory slab & return it
             void* const page = ::mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-            ::mmap(page, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0); // 1st page of memory
+            if (page == MAP_FAILED)
+            {
+                ::close(fd);
+                return nullptr;
+            }
+
+            if (::mmap(page, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) // 1st page of memory
+            {
+                ::munmap(page, size);
+                ::close(fd);
+                return nullptr;
+            }
 
             return ::close(fd), page;
         }
@@ -66,12 +88,242 @@ namespace comm {
 
     //! Deallocates an existing memory map
     //! @param src     memory map
-    //! @param size    memory map size
+    //! @param size    memory map size, as returned by genmap()
     template <typename T>
     inline void delmap(void* const src,
                        const std::size_t size)
     {
-        detail::delmap(src, sizeof(T), size * 2);
+        detail::delmap(src, sizeof(T), size);
+    }
+
+    //! @class memory_resource
+    /*! polymorphic memory resource; mirrors std::pmr::memory_resource, which is unavailable before C++17
+     */
+    class memory_resource {
+    public:
+
+        //! dtor.
+        virtual ~memory_resource() {}
+
+        //! Allocates memory; throws std::bad_alloc on failure
+        void* allocate(const std::size_t bytes, const std::size_t alignment = alignof(std::max_align_t)) {
+            return do_allocate(bytes, alignment);
+        }
+
+        //! Deallocates memory returned by allocate()
+        void deallocate(void* const ptr, const std::size_t bytes, const std::size_t alignment = alignof(std::max_align_t)) {
+            do_deallocate(ptr, bytes, alignment);
+        }
+
+        //! @get
+        bool is_equal(const memory_resource& other) const noexcept {
+            return do_is_equal(other);
+        }
+
+    protected:
+
+        virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+        virtual void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) = 0;
+
+        virtual bool do_is_equal(const memory_resource& other) const noexcept {
+            return this == &other;
+        }
+    };
+
+    //! @class heap_resource
+    /*! memory resource that uses dynamic memory
+     */
+    class heap_resource : public memory_resource {
+    protected:
+
+        void* do_allocate(const std::size_t bytes, const std::size_t alignment) override {
+
+            void* ptr;
+            if (::posix_memalign(&ptr, alignment < sizeof(void*) ? sizeof(void*) : alignment, bytes) != 0) {
+                throw std::bad_alloc();
+            }
+
+            return ptr;
+        }
+
+        void do_deallocate(void* const ptr, std::size_t, std::size_t) override {
+            ::free(ptr);
+        }
+    };
+
+    //! @class map_resource
+    /*! memory resource that uses memmap; allocations are expanded up to page size border and page aligned
+     */
+    class map_resource : public memory_resource {
+    protected:
+
+        void* do_allocate(const std::size_t bytes, std::size_t) override {
+
+            std::size_t size = bytes;
+
+            void* ptr;
+            if ((ptr = detail::genmap(1, &size)) == nullptr) {
+                throw std::bad_alloc();
+            }
+
+            return ptr;
+        }
+
+        void do_deallocate(void* const ptr, const std::size_t bytes, std::size_t) override {
+
+            const std::size_t pageSize = getpagesize();
+            detail::delmap(ptr, 1, bytes % pageSize ? bytes + pageSize - (bytes % pageSize) : bytes);
+        }
+    };
+
+    //! @class counting_resource
+    /*! memory resource that forwards to another resource and records how much memory passes through it
+     */
+    class counting_resource : public memory_resource {
+    public:
+
+        //! ctor.
+        //! @param upstream    resource that performs the allocations
+        explicit counting_resource(memory_resource* upstream) : upstream_(upstream)
+                                                              , allocations_(0)
+                                                              , bytes_(0)
+                                                              , peak_(0) {}
+
+        //! @get
+        //! @return number of live allocations
+        std::size_t get_allocation_count() const {
+            return allocations_;
+        }
+
+        //! @get
+        //! @return number of bytes currently allocated
+        std::size_t get_allocated_bytes() const {
+            return bytes_;
+        }
+
+        //! @get
+        //! @return highest number of bytes allocated at any one time
+        std::size_t get_peak_bytes() const {
+            return peak_;
+        }
+
+    protected:
+
+        void* do_allocate(const std::size_t bytes, const std::size_t alignment) override {
+
+            void* ptr = upstream_->allocate(bytes, alignment);
+
+            ++allocations_;
+            const std::size_t total = bytes_ += bytes;
+
+            std::size_t peak = peak_.load();
+            while (total > peak && !peak_.compare_exchange_weak(peak, total))
+            {}
+
+            return ptr;
+        }
+
+        void do_deallocate(void* const ptr, const std::size_t bytes, const std::size_t alignment) override {
+
+            upstream_->deallocate(ptr, bytes, alignment);
+
+            --allocations_;
+            bytes_ -= bytes;
+        }
+
+    private:
+
+        memory_resource* upstream_;
+
+        std::atomic<std::size_t> allocations_;
+        std::atomic<std::size_t> bytes_;
+        std::atomic<std::size_t> peak_;
+    };
+
+#if __cplusplus >= 201703L
+    //! @class pmr_resource
+    /*! adapts a std::pmr::memory_resource, e.g. std::pmr::monotonic_buffer_resource
+     */
+    class pmr_resource : public memory_resource {
+    public:
+
+        //! ctor.
+        explicit pmr_resource(std::pmr::memory_resource* upstream) : upstream_(upstream) {}
+
+    protected:
+
+        void* do_allocate(const std::size_t bytes, const std::size_t alignment) override {
+            return upstream_->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* const ptr, const std::size_t bytes, const std::size_t alignment) override {
+            upstream_->deallocate(ptr, bytes, alignment);
+        }
+
+    private:
+
+        std::pmr::memory_resource* upstream_;
+    };
+#endif
+
+    //! @return process-wide dynamic memory resource
+    inline memory_resource* get_heap_resource()
+    {
+        static heap_resource resource;
+        return &resource;
+    }
+
+    //! @return process-wide memmap resource
+    inline memory_resource* get_map_resource()
+    {
+        static map_resource resource;
+        return &resource;
+    }
+
+    //! @class resource_allocator
+    /*! standard allocator adapter for memory_resource, used with standard containers
+     */
+    template <typename T>
+    class resource_allocator {
+    public:
+
+        typedef T value_type;
+
+        //! ctor.
+        resource_allocator(memory_resource* resource = get_heap_resource()) : resource_(resource) {}
+
+        //! ctor.
+        template <typename Q>
+        resource_allocator(const resource_allocator<Q>& other) : resource_(other.resource()) {}
+
+        T* allocate(const std::size_t n) {
+            return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* const ptr, const std::size_t n) {
+            resource_->deallocate(ptr, n * sizeof(T), alignof(T));
+        }
+
+        //! @get
+        memory_resource* resource() const {
+            return resource_;
+        }
+
+    private:
+
+        memory_resource* resource_;
+    };
+
+    template <typename T, typename Q>
+    inline bool operator==(const resource_allocator<T>& lhs, const resource_allocator<Q>& rhs)
+    {
+        return lhs.resource()->is_equal(*rhs.resource());
+    }
+
+    template <typename T, typename Q>
+    inline bool operator!=(const resource_allocator<T>& lhs, const resource_allocator<Q>& rhs)
+    {
+        return !(lhs == rhs);
     }
 }
 
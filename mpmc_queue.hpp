@@ -0,0 +1,183 @@
+/* mpmc_queue.hpp -- v1.0 -- bounded multi-producer, multi-consumer queue with lock-free concurrency control
+   Author: Sam Y. 2026 */
+
+#ifndef _COMM_MPMC_QUEUE_HPP
+#define _COMM_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mem.hpp"
+
+namespace comm {
+
+    //! @class mpmc_queue
+    /*! bounded FIFO queue; each slot carries a sequence number that tells producers and consumers whose turn it is,
+     *! so that a push or pop takes one compare-and-swap on an index, and no allocation
+     */
+    template <typename T>
+    class mpmc_queue {
+    public:
+
+        //! dtor.
+        //!
+        ~mpmc_queue() {
+
+            // Values left over; no producer or consumer is running
+            const std::size_t end = enqueuePos_.load();
+            for (std::size_t pos = dequeuePos_.load(); pos != end; ++pos) {
+                reinterpret_cast<T*>(&cells_[pos & mask_].storage)->~T();
+            }
+
+            resource_->deallocate(cells_, sizeof(cell) * capacity_, alignof(cell));
+        }
+
+        //! ctor.
+        //! @param capacity    maximum number of queued values, rounded up to a power of two
+        //! @param resource    memory resource used for the slots
+        explicit mpmc_queue(const std::size_t capacity, memory_resource* resource = get_heap_resource())
+            : resource_(resource)
+            , capacity_(2)
+            , enqueuePos_(0)
+            , dequeuePos_(0) {
+
+            while (capacity_ < capacity) {
+                capacity_ <<= 1;
+            }
+
+            mask_ = capacity_ - 1;
+            cells_ = static_cast<cell*>(resource_->allocate(sizeof(cell) * capacity_, alignof(cell)));
+
+            for (std::size_t i = 0; i != capacity_; ++i) {
+                new (&cells_[i].sequence) std::atomic<std::size_t>(i);
+            }
+        }
+
+        //! @get
+        //! @return maximum number of queued values
+        std::size_t get_capacity() const {
+            return capacity_;
+        }
+
+        //! @get
+        //! @return number of queued values; approximate while the queue is in use
+        std::size_t get_size() const {
+
+            const std::size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+            const std::size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        /*! Appends value
+         *! @return false if the queue is full
+         */
+        template <typename U>
+        bool push(U&& value) {
+
+            cell* c;
+            std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                c = &cells_[pos & mask_];
+
+                const std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+                // Slot is free for this position
+                if (diff == 0)
+                {
+                    if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+
+                // Slot still holds the value of the previous lap
+                else if (diff < 0) {
+                    return false;
+                }
+
+                else {
+                    pos = enqueuePos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            new (&c->storage) T(std::forward<U>(value));
+            c->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /*! Removes the oldest value
+         *! @param value    [out] removed value
+         *! @return         false if the queue is empty
+         */
+        bool pop(T& value) {
+
+            cell* c;
+            std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                c = &cells_[pos & mask_];
+
+                const std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+
+                // Slot holds the value for this position
+                if (diff == 0)
+                {
+                    if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+
+                // Slot not written yet
+                else if (diff < 0) {
+                    return false;
+                }
+
+                else {
+                    pos = dequeuePos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            T* const stored = reinterpret_cast<T*>(&c->storage);
+            value = std::move(*stored);
+            stored->~T();
+
+            // Free for the next lap
+            c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+
+        static const std::size_t CACHE_LINE = 64;
+
+        // Queue slot; the sequence number equals the position a producer may write next,
+        // or position + 1 once the value can be read
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        memory_resource* resource_;
+        std::size_t capacity_;
+        std::size_t mask_;
+        cell* cells_;
+
+        // Producers and consumers each keep to their own cache line
+        char pad0_[CACHE_LINE];
+        std::atomic<std::size_t> enqueuePos_;
+        char pad1_[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::size_t> dequeuePos_;
+        char pad2_[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+
+        // Non-copyable object
+        explicit mpmc_queue(mpmc_queue&) = delete;
+        explicit mpmc_queue(const mpmc_queue&) = delete;
+    };
+}
+
+#endif
@@ -2,48 +2,501 @@
    Author: Sam Y. 2021-22 
 
    pool.hpp -- v1.1
-   Modified: Class now uses stack for memory management, 2023 */
+   Modified: Class now uses stack for memory management, 2023
+
+   pool.hpp -- v1.2
+   Modified: Client slab grows in chunks on demand, idle chunks can be released
+
+   pool.hpp -- v1.3
+   Modified: Client records and read buffers are stored in separate arrays
+
+   pool.hpp -- v1.4
+   Modified: Each client slot stores a user-defined context, passed to callbacks
+
+   pool.hpp -- v1.5
+   Modified: Pool allocations go through a pluggable memory resource
+
+   pool.hpp -- v1.6
+   Modified: Server accepts connections on multiple threads, with SO_REUSEPORT listener groups
+
+   pool.hpp -- v1.7
+   Modified: Connections are accepted with accept4() and handed to the client pool in batches
+
+   pool.hpp -- v1.8
+   Modified: Peer addresses are stored per slot, connections are admitted by per-source limits
+
+   pool.hpp -- v1.9
+   Modified: Listeners can steer connections to the acceptor of the receiving CPU, threads can be pinned
+
+   pool.hpp -- v1.10
+   Modified: Server binds IPv6 and Unix-domain listeners
+
+   pool.hpp -- v1.11
+   Modified: Idle connections can be evicted when the pool is full
+
+   pool.hpp -- v1.12
+   Modified: Client pool tracks worker load, server backs off accepting while workers are overloaded
+
+   pool.hpp -- v1.13
+   Modified: Server binds listeners with a socket option profile
+
+   pool.hpp -- v1.14
+   Modified: Socket buffers of idle connections can be shrunk, added a memory report of live connections
+
+   pool.hpp -- v1.15
+   Modified: Workers can be added and retired while running, by hand or from measured utilization
+
+   pool.hpp -- v1.16
+   Modified: Handlers can offload work to a compute pool, completions are run back on the worker threads
+
+   pool.hpp -- v1.17
+   Modified: Each connection has a strand, running posted tasks one at a time and in order on any worker
+
+   pool.hpp -- v1.18
+   Modified: Listeners and live connections can be handed off to a new process, for restarts without dropping connections
+
+   pool.hpp -- v1.19
+   Modified: Handlers can send messages to other connections, over single-producer rings between workers
+
+   pool.hpp -- v1.20
+   Modified: Workers can publish messages to a sequencer, processed in order on one business-logic thread
+
+   pool.hpp -- v1.21
+   Modified: Workers can read shared objects of an epoch domain without locks, every poll is a quiescent point
+
+   pool.hpp -- v1.22
+   Modified: Workers process a bounded batch of events per poll and defer the rest, idle workers steal deferred events
+
+   pool.hpp -- v1.23
+   Modified: Reads per event are bounded by a byte and message budget, connections out of budget are resumed later
+
+   pool.hpp -- v1.24
+   Modified: Connections can be put in priority classes, served by weighted round-robin or strict priority */
 
 #ifndef _COMM_POOL_HPP
 #define _COMM_POOL_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 
+#include "admission.hpp"
 #include "atomic_stack.hpp"
+#include "epoch.hpp"
 #include "epoll.hpp"
+#include "executor.hpp"
+#include "handoff.hpp"
+#include "mpmc_queue.hpp"
+#include "sequencer.hpp"
+#include "spsc_queue.hpp"
+#include "steal_deque.hpp"
 
 namespace comm {
 
     class client_pool_base {};
     class server_pool_base {};
 
+    namespace detail {
+
+        // Overload ranks, used to prefer the richest callback signature the handler implements
+        struct rank0 {};
+        struct rank1 : rank0 {};
+        struct rank2 : rank1 {};
+
+        /*! Invokes on_input(), preferring the context-aware, then the handle-aware signature
+         */
+        template <typename T, typename Tctx>
+        inline auto on_input(T& handler, const handle h, const int sfd, Tctx& ctx, char* data, const int datalen, rank2)
+            -> decltype(handler.on_input(h, sfd, ctx, data, datalen), void())
+        {
+            handler.on_input(h, sfd, ctx, data, datalen);
+        }
+
+        template <typename T, typename Tctx>
+        inline auto on_input(T& handler, const handle h, const int sfd, Tctx&, char* data, const int datalen, rank1)
+            -> decltype(handler.on_input(h, sfd, data, datalen), void())
+        {
+            handler.on_input(h, sfd, data, datalen);
+        }
+
+        template <typename T, typename Tctx>
+        inline void on_input(T& handler, const handle, const int sfd, Tctx&, char* data, const int datalen, rank0)
+        {
+            handler.on_input(sfd, data, datalen);
+        }
+
+        /*! Invokes on_oob(), preferring the context-aware, then the handle-aware signature
+         */
+        template <typename T, typename Tctx>
+        inline auto on_oob(T& handler, const handle h, const int sfd, Tctx& ctx, const char oobdata, rank2)
+            -> decltype(handler.on_oob(h, sfd, ctx, oobdata), void())
+        {
+            handler.on_oob(h, sfd, ctx, oobdata);
+        }
+
+        template <typename T, typename Tctx>
+        inline auto on_oob(T& handler, const handle h, const int sfd, Tctx&, const char oobdata, rank1)
+            -> decltype(handler.on_oob(h, sfd, oobdata), void())
+        {
+            handler.on_oob(h, sfd, oobdata);
+        }
+
+        template <typename T, typename Tctx>
+        inline void on_oob(T& handler, const handle, const int sfd, Tctx&, const char oobdata, rank0)
+        {
+            handler.on_oob(sfd, oobdata);
+        }
+
+        /*! Invokes on_write_ready(), preferring the context-aware, then the handle-aware signature
+         */
+        template <typename T, typename Tctx>
+        inline auto on_write_ready(T& handler, const handle h, const int sfd, Tctx& ctx, rank2)
+            -> decltype(handler.on_write_ready(h, sfd, ctx), void())
+        {
+            handler.on_write_ready(h, sfd, ctx);
+        }
+
+        template <typename T, typename Tctx>
+        inline auto on_write_ready(T& handler, const handle h, const int sfd, Tctx&, rank1)
+            -> decltype(handler.on_write_ready(h, sfd), void())
+        {
+            handler.on_write_ready(h, sfd);
+        }
+
+        template <typename T, typename Tctx>
+        inline void on_write_ready(T& handler, const handle, const int sfd, Tctx&, rank0)
+        {
+            handler.on_write_ready(sfd);
+        }
+
+        /*! Invokes on_hand_off() if the handler implements it
+         */
+        template <typename T, typename Tctx>
+        inline auto on_hand_off(T& handler, const handle h, const int sfd, Tctx& ctx, std::string& state, rank1)
+            -> decltype(handler.on_hand_off(h, sfd, ctx, state), void())
+        {
+            handler.on_hand_off(h, sfd, ctx, state);
+        }
+
+        template <typename T, typename Tctx>
+        inline void on_hand_off(T&, const handle, const int, Tctx&, std::string&, rank0) {}
+
+        /*! Invokes on_take_over() if the handler implements it
+         */
+        template <typename T, typename Tctx>
+        inline auto on_take_over(T& handler, const handle h, const int sfd, Tctx& ctx, const char* state,
+                                 const std::size_t size, rank1)
+            -> decltype(handler.on_take_over(h, sfd, ctx, state, size), void())
+        {
+            handler.on_take_over(h, sfd, ctx, state, size);
+        }
+
+        template <typename T, typename Tctx>
+        inline void on_take_over(T&, const handle, const int, Tctx&, const char*, const std::size_t, rank0) {}
+
+        /*! Invokes on_message() if the handler implements it, otherwise writes the message to the connection
+         */
+        template <typename T, typename Tctx>
+        inline auto on_message(T& handler, const handle h, const int sfd, Tctx& ctx, const char* data,
+                               const std::size_t size, rank1)
+            -> decltype(handler.on_message(h, sfd, ctx, data, size), void())
+        {
+            handler.on_message(h, sfd, ctx, data, size);
+        }
+
+        template <typename T, typename Tctx>
+        inline void on_message(T&, const handle, const int sfd, Tctx&, const char* data, const std::size_t size, rank0)
+        {
+            endpoint_write(sfd, data, static_cast<int>(size));
+        }
+
+        /*! Invokes on_sequenced() if the handler implements it
+         */
+        template <typename T>
+        inline auto on_sequenced(T& handler, const handle h, const char* data, const std::size_t size,
+                                 const bool endOfBatch, rank1)
+            -> decltype(handler.on_sequenced(h, data, size, endOfBatch), void())
+        {
+            handler.on_sequenced(h, data, size, endOfBatch);
+        }
+
+        template <typename T>
+        inline void on_sequenced(T&, const handle, const char*, const std::size_t, const bool, rank0) {}
+
+        /*! Returns monotonic time in microseconds
+         */
+        inline std::uint64_t clock_us()
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /*! Pins thread to every CPU c where c % stride == offset
+         *! @return false if there is no such CPU, or the affinity cannot be set
+         */
+        inline bool pin_thread(const pthread_t thread, const std::size_t offset, const std::size_t stride)
+        {
+            const std::size_t cpuCount = std::max(1u, std::thread::hardware_concurrency());
+
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (std::size_t cpu = offset; cpu < cpuCount && cpu < CPU_SETSIZE; cpu += stride) {
+                CPU_SET(cpu, &set);
+            }
+
+            return CPU_COUNT(&set) != 0 && ::pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+        }
+    }
+
+    //! @struct memory_report
+    /* estimated memory held by live connections, in bytes
+     */
+    struct memory_report {
+
+        // Estimate of the slab objects of an idle TCP socket, which SO_MEMINFO does not report; object sizes
+        // taken from Linux 6.x on x86-64: tcp_sock 2368, socket inode 832, file 192, dentry 192, and epoll item
+        // 128 bytes. Not measured, and varies with kernel version and configuration
+        static const std::size_t SOCKET_OVERHEAD = 3712;
+
+        // Live connections
+        std::size_t connections;
+        // Live connections with shrunk socket buffers
+        std::size_t shrunk;
+        // Kernel memory in use by all sockets, see socket_memory
+        std::uint64_t receiveQueued;
+        std::uint64_t sendQueued;
+        std::uint64_t reserved;
+        // Buffer sizes of all sockets; the most memory the sockets may take
+        std::uint64_t receiveLimit;
+        std::uint64_t sendLimit;
+        // Pool memory of one client slot: record, read buffer, context and peer record
+        std::size_t slotSize;
+
+        //! ctor.
+        memory_report() : connections(0)
+                        , shrunk(0)
+                        , receiveQueued(0)
+                        , sendQueued(0)
+                        , reserved(0)
+                        , receiveLimit(0)
+                        , sendLimit(0)
+                        , slotSize(0) {}
+
+        //! @get
+        //! @return estimated kernel memory per connection, in use: the buffer memory reported by the kernel,
+        //!         plus the fixed estimate SOCKET_OVERHEAD
+        std::size_t get_kernel_per_connection() const {
+
+            return connections != 0
+                ? SOCKET_OVERHEAD + static_cast<std::size_t>((receiveQueued + sendQueued + reserved) / connections)
+                : 0;
+        }
+
+        //! @get
+        //! @return estimated kernel and pool memory per connection, in use
+        std::size_t get_per_connection() const {
+
+            return connections != 0 ? get_kernel_per_connection() + slotSize : 0;
+        }
+    };
+
+    //! @struct priority_stats
+    /* service received by one priority class, summed over workers
+     */
+    struct priority_stats {
+
+        // Times a connection was served; events that arrive while it is served are processed along with it
+        std::uint64_t served;
+        // Time spent serving them, in microseconds
+        std::uint64_t busyTime;
+        // Connections waiting for their turn
+        std::size_t queued;
+
+        //! ctor.
+        priority_stats() : served(0)
+                         , busyTime(0)
+                         , queued(0) {}
+    };
+
+    //! @struct worker_scaling
+    /* bounds and thresholds of automatic worker scaling; utilization is the share of time workers spend processing
+       events rather than polling for them, averaged over workers
+     */
+    struct worker_scaling {
+
+        // Bounds of the worker count
+        std::size_t minWorkers;
+        std::size_t maxWorkers;
+        // Utilization in percent above which a worker is added
+        unsigned scaleUp;
+        // Utilization in percent below which a worker is retired
+        unsigned scaleDown;
+        // Time between two scaling decisions, in microseconds; utilization is averaged over it
+        std::uint64_t interval;
+
+        //! ctor.
+        worker_scaling() : minWorkers(0)
+                         , maxWorkers(0)
+                         , scaleUp(75)
+                         , scaleDown(25)
+                         , interval(1000000) {}
+    };
+
     //! @class client_pool
     /*! encapsulates event handling for multiple clients
+     *! client slots are allocated in fixed-size chunks on demand, up to a hard limit; slots never move
+     *! each slot holds a Tctx, constructed when a connection is added and destroyed when it is closed
      */
-    template <typename Tderiv>
+    template <typename Tderiv, typename Tctx = no_context>
     class client_pool : public client_pool_base,
-                        public epoll<client_pool<Tderiv> > {
+                        public epoll<client_pool<Tderiv, Tctx> > {
+
+        static_assert(CACHE_LINE_SIZE % sizeof(atomic_node<client>) == 0,
+                      "client records must not straddle cache lines");
+
     public:
 
+        static const std::size_t DEFAULT_CHUNK_SIZE = 4096;
+        static const std::size_t MAX_PRIORITY_CLASSES = 8;
+
+        // Evictions tried per connection before giving up
+        static const int EVICT_ATTEMPTS = 4;
+
         //! dtor.
         //
         ~client_pool() {
 
-            std::lock_guard<std::mutex> lock(lock_);
-            freeMem_.destroy();
+            if (notifyfd_ != -1) {
+                endpoint_close(notifyfd_);
+            }
+
+            std::lock_guard<std::mutex> lock(slabLock_);
+            for (std::size_t i = 0; i != maxChunks_; ++i)
+            {
+                atomic_node<client>* chunk = chunks_[i].load();
+                if (chunk != nullptr)
+                {
+                    // Contexts of connections that were never closed
+                    for (std::size_t j = 0; j != chunkSize_; ++j)
+                    {
+                        if (chunk[j].sfd) {
+                            context_of(&chunk[j]).~Tctx();
+                        }
+                    }
+
+                    release(i, chunk);
+                }
+            }
         }
 
         //! ctor.
-        //! @param workerCount     client handler thread count
-        //! @param clientCap    maximum number of clients
-        client_pool(const std::size_t workerCount, std::size_t clientCap) : workerCount_(workerCount)
-                                                                          , clientCap_(clientCap)
-                                                                          , clientCount_(0) {
-            if (!freeMem_.create(&clientCap_)) {
+        //! @param workerCount    client handler thread count
+        //! @param clientCap      maximum number of clients
+        //! @param chunkSize      number of client slots allocated at a time,
+        //!                       will be expanded up to page size border
+        //! @param resource       memory resource used for all pool allocations;
+        //!                       by default, client slots are memmapped and the rest uses dynamic memory
+        client_pool(const std::size_t workerCount,
+                    const std::size_t clientCap,
+                    const std::size_t chunkSize = DEFAULT_CHUNK_SIZE,
+                    memory_resource* resource = nullptr)
+            : epoll<client_pool<Tderiv, Tctx> >(resource != nullptr ? resource : get_heap_resource())
+            , resource_(resource != nullptr ? resource : get_heap_resource())
+            , slabResource_(resource != nullptr ? resource : get_map_resource())
+            , admission_(clientCap, resource_)
+            , workerCount_(workerCount)
+            , clientCap_(0)
+            , chunkSize_(chunkSize)
+            , maxChunks_(0)
+            , clientCount_(0)
+            , capacity_(0)
+            , readers_(0)
+            , threads_(resource_allocator<std::thread>(resource_))
+            , pinWorkers_(false)
+            , evictIdle_(false)
+            , hand_(0)
+            , evicted_(0)
+            , trackLoad_(false)
+            , lastPoll_(0)
+            , window_(0)
+            , cycle_(0)
+            , lastCycle_(0)
+            , depth_(0)
+            , shrinkIdle_(false)
+            , restoreIdle_(false)
+            , idleTime_(0)
+            , idleReceive_(0)
+            , idleSend_(0)
+            , sweepTime_(0)
+            , sweepHand_(0)
+            , shrunk_(0)
+            , busy_(0)
+            , polled_(0)
+            , utilization_(0)
+            , scaling_()
+            , stopScaling_(false)
+            , strands_(false)
+            , notifyfd_(-1)
+            , offload_(false)
+            , offloaded_(0)
+            , offloadCap_(0)
+            , mesh_(false)
+            , meshCap_(0)
+            , laneCount_(0)
+            , epochs_(nullptr)
+            , stealing_(false)
+            , stealBatch_(0)
+            , stealCap_(0)
+            , dequeCount_(0)
+            , readBytes_(0)
+            , readMessages_(0)
+            , yielding_(false)
+            , prioritized_(false)
+            , strictPriority_(false)
+            , classCount_(0)
+            , defaultClass_(0) {
+            // Expand chunk size to page size border, as done by the allocator
+            const std::size_t pageSize = getpagesize();
+            if (chunkSize_ % pageSize) {
+                chunkSize_ = chunkSize_ + pageSize - (chunkSize_ % pageSize);
+            }
+
+            maxChunks_ = (clientCap + chunkSize_ - 1) / chunkSize_;
+            if (maxChunks_ == 0) {
+                maxChunks_ = 1;
+            }
+
+            clientCap_ = maxChunks_ * chunkSize_;
+
+            chunks_.reset(new std::atomic<atomic_node<client>*>[maxChunks_]);
+            buffers_.reset(new client_buffer*[maxChunks_]);
+            contexts_.reset(new context_storage*[maxChunks_]);
+            peers_.reset(new peer_record*[maxChunks_]);
+            generations_.reset(new std::uint32_t[maxChunks_]);
+            for (std::size_t i = 0; i != maxChunks_; ++i)
+            {
+                chunks_[i].store(nullptr);
+                buffers_[i] = nullptr;
+                contexts_[i] = nullptr;
+                peers_[i] = nullptr;
+                generations_[i] = 1;
+            }
+
+            // First chunk is allocated up front
+            if (!allocate(0)) {
                 throw std::bad_alloc();
             }
         }
@@ -55,437 +508,3835 @@ namespace comm {
             return clientCount_;
         }
 
-        //! Adds a new client
-        //! @param sfd    file descriptor
-        bool add_client(const int sfd) {
+        //! @get
+        //! @return memory resource used for general allocations
+        memory_resource* get_memory_resource() const {
 
-            client* cl;
-            if ((cl = use(sfd)) == nullptr)
-                return false;
-            return epoll<client_pool>::add(cl) == 0;
+            return resource_;
         }
 
-        //! Starts instance
-        //!
-        void run() {
+        //! @get
+        //! @return number of currently allocated client slots
+        std::size_t get_capacity() const {
 
-            std::lock_guard<std::mutex> lock(lock_);
+            return capacity_;
+        }
 
-            if (threads_.empty())
-            {
-                threadCount_.store(workerCount_);
-                for (std::size_t i = 0; i != workerCount_; ++i)
-                {
-                    threads_.emplace_back([this] {
-                        epoll<client_pool<Tderiv> >::wait(threadCount_);
-                    });
-                }
-            }
+        //! @get
+        //! @param h    connection handle
+        //! @return     true if the handle refers to a live connection
+        bool is_valid(const handle h) const {
+
+            ++readers_;
+            const bool ret = lookup(h) != nullptr;
+            --readers_;
+            return ret;
         }
 
-        //! Stops running instance
-        //!
-        void stop() {
+        //! @get
+        //! @param h    connection handle
+        //! @return     file descriptor of the connection, -1 if the handle is stale
+        int get_descriptor(const handle h) const {
 
-            std::lock_guard<std::mutex> lock(lock_);
+            ++readers_;
+            const client* cl = lookup(h);
+            const int sfd = cl != nullptr ? cl->sfd : -1;
+            --readers_;
+            return sfd;
+        }
 
-            if (!threads_.empty())
-            {
-                // Master thread initiates the shutdown daisy-chain
-                epoll<client_pool<Tderiv> >::close();
-                for (std::size_t i = 0; i != threads_.size(); ++i) {
-                    threads_[i].join();
-                }
+        //! @get
+        //! @param h    connection handle
+        //! @return     total bytes received on the connection, 0 if the handle is stale
+        std::uint64_t get_received(const handle h) const {
 
-                threads_.clear();
+            ++readers_;
+            const client* cl = lookup(h);
+            const std::uint64_t received = cl != nullptr ? cl->received : 0;
+            --readers_;
+            return received;
+        }
 
-                // Maybe reset clients...
-                atomic_node<client>* data = freeMem_.data();
-                for (std::size_t i = 0; i != clientCap_; ++i)
-                {
-                    client& ref = static_cast<client&>(data[i]);
-                    // Maybe reset client
-                    if (ref.sfd) {
-                        unuse(&ref);
-                    }
-                }
+        //! @get
+        //! @param h       connection handle
+        //! @param peer    [out] peer address of the connection
+        //! @return        false if the handle is stale
+        bool get_peer(const handle h, peer_address& peer) const {
+
+            ++readers_;
+            const client* cl = lookup(h);
+            if (cl != nullptr) {
+                peer = peer_of(cl).address;
             }
-        }
 
-        //! Override this to handle out-of-band events
-        //! @param sfd        triggered file descriptor
-        //! @param oobdata    oob byte
-        inline void on_oob(int sfd, char oobdata) {
-            (void)sfd;
-            (void)oobdata;
+            // The slot may have been reused while copying
+            const bool ret = cl != nullptr && cl->generation.load(std::memory_order_acquire) == h.generation();
+            --readers_;
+            return ret;
         }
 
-        //! Override to handle input events
-        //! @param sfd        triggered file descriptor
-        //! @param data       received data
-        //! @param datalen    received data length
-        inline void on_input(int sfd, char* data, int datalen) {
-            (void)sfd;
-            (void)data;
-            (void)datalen;
+        //! @get
+        //! @return admission stage, with its policy and counters
+        const admission& get_admission() const {
+
+            return admission_;
         }
 
-        //! Override this to handle output-ready events
-        //! @param sfd    triggered file descriptor
-        inline void on_write_ready(int sfd) {
-            (void)sfd;
+        //! Sets the per-source connection limits applied by add_client(); not safe to call while clients are being added
+        //! @param policy    limits; a default-constructed policy admits everyone
+        //! @return          false if the admission table could not be allocated
+        bool set_admission_policy(const admission_policy& policy) {
+
+            return admission_.set_policy(policy);
         }
 
-    private:
+        //! @get
+        //! @return number of connections closed to make room for new ones
+        std::size_t get_evicted_count() const {
 
-        friend epoll<client_pool<Tderiv> >;
+            return evicted_;
+        }
 
-        // Applied to critical section when starting and stopping the running instance
-        mutable std::mutex lock_;
+        //! @get
+        //! Requires load tracking, see set_load_tracking()
+        //! @return event-loop lag in microseconds: the time since any worker last polled for events, or the
+        //!         longest time a worker took between two polls over the last one to two windows, whichever is longer
+        std::uint64_t get_lag() const {
 
-        // Threads
-        std::size_t workerCount_; // Total # of worker threads
-        std::size_t clientCap_; // Total # of allowed clients
+            const std::uint64_t last = lastPoll_.load(std::memory_order_relaxed);
+            const std::uint64_t now = detail::clock_us();
+            return std::max(last != 0 && now > last ? now - last : 0,
+                            std::max(cycle_.load(std::memory_order_relaxed), lastCycle_.load(std::memory_order_relaxed)));
+        }
 
-        std::atomic<std::size_t> clientCount_; // Current number of allocated clients
+        //! @get
+        //! Requires load tracking, see set_load_tracking()
+        //! @return number of events returned by the latest poll of any worker
+        std::size_t get_depth() const {
 
-        atomic_stack<client> freeMem_; // Stack of allocated inactive clients
+            return depth_.load(std::memory_order_relaxed);
+        }
 
-        std::vector<std::thread> threads_; // Workers
-        std::atomic<std::size_t> threadCount_; // Current number of running threads
+        //! @get
+        //! Requires load tracking, see set_load_tracking()
+        //! @return share of time workers spent processing events over the last window, in percent
+        unsigned get_utilization() const {
 
-        /*! Called on epoll event, casts epoll data value to correct type before passing it to process()
-         */
-        client* cast(epoll_data data) {
-            return static_cast<client*>(data.ptr);
+            return utilization_.load(std::memory_order_relaxed);
         }
 
-        /*! Called on epoll event to processes triggered file descriptor
-         */
-        inline void process(client* const cl, const int flags);
+        //! Enables tracking of worker load; only valid while not running
+        //! Costs one clock read per poll
+        //! @param track    true to track worker lag, queue depth and utilization
+        bool set_load_tracking(const bool track) {
 
-        /*! Closes socket and stores client to unused queue
-         */
-        void unuse(client* const cl) {
+            std::lock_guard<std::mutex> lock(lock_);
 
-            epoll<client_pool>::remove(cl->sfd);
-            endpoint_close(cl->sfd);
-            cl->sfd = 0;
-            freeMem_.push(cl);
-            --clientCount_;
+            if (!threads_.empty()) {
+                return false;
+            }
+
+            trackLoad_ = track;
+            return true;
         }
 
-        /*! Allocates new client
-         */
-        client* use(const int sfd) {
+        //! Enables eviction of idle connections; only valid while not running
+        //! Once enabled, a connection that cannot get a slot because the pool is full takes the slot of the least
+        //! recently active connection instead, found by clock sweep. Connections being processed are never evicted.
+        //! Costs two atomic operations per event.
+        //! @param evict    true to evict idle connections when the pool is full
+        bool set_idle_eviction(const bool evict) {
 
-            client* mem;
-            if ((mem = freeMem_.pop()) == nullptr) {
-                return nullptr;
-            }
+            std::lock_guard<std::mutex> lock(lock_);
 
-            else
-            {
-                ++clientCount_;
-                return new (mem) client(sfd);
+            if (!threads_.empty()) {
+                return false;
             }
+
+            evictIdle_ = evict;
+            return true;
         }
 
-        /*! EPOLLOUT
-         */
-        inline void handle_epollout(client* const);
-        /*! EPOLLIN
-         */
-        inline void handle_epollin(client* const);
-        /*! EPOLLPRI
-         */
-        inline void handle_epollpri(client* const);
-    };
+        //! Shrinks the kernel socket buffers of idle connections; only valid while not running
+        //! Connections are swept by worker threads, and shrunk after idleTime to twice idleTime without events.
+        //! Setting a buffer size turns off kernel auto-tuning of that buffer for the rest of the connection. Shrunk
+        //! buffers therefore keep their idle size, unless restore is set: they then get the size they had before
+        //! shrinking back on the next event, and keep that size from then on.
+        //! Costs one clock read per poll, and two atomic operations per event.
+        //! @param idleTime         microseconds without events before shrinking, 0 disables
+        //! @param receiveBuffer    SO_RCVBUF of idle connections, 0 leaves the size unchanged
+        //! @param sendBuffer       SO_SNDBUF of idle connections, 0 leaves the size unchanged
+        //! @param restore          true to give shrunk buffers their previous size back on the next event
+        bool set_buffer_shrinking(const std::uint64_t idleTime,
+                                  const int receiveBuffer,
+                                  const int sendBuffer,
+                                  const bool restore = false) {
 
+            std::lock_guard<std::mutex> lock(lock_);
 
-    /*! Processes epoll events
-     */
-    template <typename Tderiv>
-    void client_pool<Tderiv>::process(client* const client, int flags)
-    {
-        switch (flags)
+            if (!threads_.empty()) {
+                return false;
+            }
+
+            shrinkIdle_ = idleTime != 0 && (receiveBuffer != 0 || sendBuffer != 0);
+            restoreIdle_ = shrinkIdle_ && restore;
+            idleTime_ = idleTime;
+            idleReceive_ = receiveBuffer;
+            idleSend_ = sendBuffer;
+            return true;
+        }
+
+        //! Bounds the input read per event; only valid while not running
+        //! A connection that reaches either bound stops reading, and goes on once the other ready connections had
+        //! their turn, so that one fast sender does not hold on to a worker. By default the connection stays owned,
+        //! and its worker resumes it after the events of its current poll. Level-triggered connections are rearmed
+        //! instead, and resumed by whichever worker polls them next, at the cost of one more syscall. Costs two
+        //! atomic operations per event, like eviction.
+        //! @param bytes           bytes read per event, 0 for no bound; checked after each read
+        //! @param messages        calls to on_input() per event, 0 for no bound
+        //! @param levelTriggered  true to watch connections level-triggered
+        bool set_read_budget(const std::size_t bytes, const std::size_t messages, const bool levelTriggered) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty()) {
+                return false;
+            }
+
+            readBytes_ = bytes;
+            readMessages_ = messages;
+            yielding_ = (bytes != 0 || messages != 0) && !levelTriggered;
+            epoll<client_pool<Tderiv, Tctx> >::set_level_triggered(levelTriggered);
+            return true;
+        }
+
+        //! Schedules connections by priority class, e.g. control, interactive and bulk; only valid while not running
+        //! Each worker queues the connections of its poll by class, then serves the queues once their events are
+        //! all queued: with weighted round-robin, each class gets up to its weight of connections per poll; with
+        //! strict priority, only the first class with waiting connections is served, up to its weight. Waiting
+        //! connections stay owned. Along with a read budget, a connection out of budget waits behind the other
+        //! connections of its class, so that bulk transfers absorb an overload rather than interactive clients.
+        //! Classes already bound the connections served per poll, so they cannot be combined with work stealing.
+        //! @param weights         connections served per poll for each class, class 0 first; empty disables classes
+        //! @param strict          true for strict priority, class 0 highest
+        //! @param defaultClass    class of new connections
+        //! @return                false if running, if work stealing is enabled, if there are more than
+        //!                        MAX_PRIORITY_CLASSES, if a weight is 0, or if defaultClass is not a class
+        bool set_priority_classes(const std::vector<unsigned>& weights, const bool strict, const std::size_t defaultClass) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty()
+                || (stealing_ && !weights.empty())
+                || weights.size() > MAX_PRIORITY_CLASSES
+                || std::find(weights.begin(), weights.end(), 0u) != weights.end()
+                || (!weights.empty() && defaultClass >= weights.size())) {
+                return false;
+            }
+
+            classes_.reset(weights.empty() ? nullptr : new priority_class[weights.size()]);
+            for (std::size_t i = 0; i != weights.size(); ++i) {
+                classes_[i].weight = weights[i];
+            }
+
+            prioritized_ = !weights.empty();
+            strictPriority_ = strict;
+            classCount_ = weights.size();
+            defaultClass_ = defaultClass;
+            return true;
+        }
+
+        //! Moves a connection to another priority class, from its next event; may be called from any thread
+        //! @param h           connection handle
+        //! @param priority    class index
+        //! @return            false if classes are disabled, if priority is not a class, or if the handle is stale
+        bool set_priority(const handle h, const std::size_t priority) {
+
+            if (priority >= classCount_) {
+                return false;
+            }
+
+            ++readers_;
+            client* cl = lookup(h);
+            if (cl != nullptr) {
+                peer_of(cl).priority.store(static_cast<unsigned>(priority), std::memory_order_relaxed);
+            }
+            --readers_;
+
+            return cl != nullptr;
+        }
+
+        //! @get
+        //! @return number of priority classes, 0 if disabled
+        std::size_t get_priority_count() const {
+            return classCount_;
+        }
+
+        //! @get
+        //! @param priority    class index
+        //! @return            service received by the class; empty if priority is not a class
+        priority_stats get_priority_stats(const std::size_t priority) const {
+
+            priority_stats stats;
+            if (priority < classCount_)
+            {
+                stats.served = classes_[priority].served.load(std::memory_order_relaxed);
+                stats.busyTime = classes_[priority].busy.load(std::memory_order_relaxed);
+                stats.queued = classes_[priority].queued.load(std::memory_order_relaxed);
+            }
+
+            return stats;
+        }
+
+        //! @get
+        //! @return number of live connections with shrunk socket buffers
+        std::size_t get_shrunk_count() const {
+
+            return shrunk_;
+        }
+
+        //! @get
+        //! Reads the kernel memory of every live connection, one syscall each; meant for diagnostics
+        //! @return memory held by live connections
+        memory_report get_memory_report() const {
+
+            memory_report report;
+            report.slotSize = sizeof(atomic_node<client>) + sizeof(client_buffer) + sizeof(context_storage)
+                + sizeof(peer_record);
+
+            ++readers_;
+            for (std::size_t i = 0; i != maxChunks_; ++i)
+            {
+                const atomic_node<client>* chunk;
+                if ((chunk = chunks_[i].load()) == nullptr) {
+                    continue;
+                }
+
+                for (std::size_t j = 0; j != chunkSize_; ++j)
+                {
+                    const std::uint32_t state = chunk[j].flags.load(std::memory_order_acquire);
+
+                    // The connection may close meanwhile, the report is an estimate
+                    socket_memory mem;
+                    if ((state & client::USED) == 0 || endpoint_memory(chunk[j].sfd, &mem) == -1) {
+                        continue;
+                    }
+
+                    ++report.connections;
+                    report.shrunk += (state & client::SHRUNK) != 0;
+                    report.receiveQueued += mem.receiveQueued;
+                    report.sendQueued += mem.sendQueued;
+                    report.reserved += mem.reserved;
+                    report.receiveLimit += mem.receiveLimit;
+                    report.sendLimit += mem.sendLimit;
+                }
+            }
+            --readers_;
+
+            return report;
+        }
+
+        //! Adds a new client
+        //! @param sfd     file descriptor
+        //! @param peer    peer address, checked against the admission policy; by default the address is unknown
+        //!                and the connection is always admitted
+        bool add_client(const int sfd, const peer_address& peer = peer_address()) {
+
+            client* cl;
+            if ((cl = admit(sfd, peer)) == nullptr)
+                return false;
+
+            return attach(cl);
+        }
+
+        //! Adds a connection handed off by another process, see server_pool::take_over()
+        //! The handler's on_take_over(handle, int, Tctx&, const char*, std::size_t), if implemented, is called with
+        //! the state exported by on_hand_off() before the connection's first event
+        //! @param sfd         file descriptor
+        //! @param peer        peer address, checked against the admission policy
+        //! @param received    total bytes received by the other process
+        //! @param state       exported state
+        //! @param size        exported state length
+        bool adopt_client(const int sfd,
+                          const peer_address& peer,
+                          const std::uint64_t received,
+                          const char* state,
+                          const std::size_t size) {
+
+            client* cl;
+            if ((cl = admit(sfd, peer)) == nullptr)
+                return false;
+
+            cl->received = received;
+            detail::on_take_over(*static_cast<Tderiv*>(this), cl->get_handle(), cl->sfd, context_of(cl), state, size,
+                                 detail::rank1());
+
+            return attach(cl);
+        }
+
+        //! Adds a batch of new clients
+        //! Descriptors that could not be added are moved to the end of the array, for the caller to close
+        //! @param sfds     file descriptors
+        //! @param peers    peer addresses, in the same order; moved along with the descriptors; may be nullptr
+        //! @param count    number of file descriptors
+        //! @return         number of clients added
+        std::size_t add_clients(int* const sfds, peer_address* const peers, const std::size_t count) {
+
+            std::size_t added = 0;
+            for (std::size_t i = 0; i != count; ++i)
+            {
+                if (add_client(sfds[i], peers != nullptr ? peers[i] : peer_address()))
+                {
+                    if (peers != nullptr) {
+                        std::swap(peers[added], peers[i]);
+                    }
+
+                    std::swap(sfds[added++], sfds[i]);
+                }
+            }
+
+            return added;
+        }
+
+        //! Adds a batch of new clients of unknown address
+        std::size_t add_clients(int* const sfds, const std::size_t count) {
+
+            return add_clients(sfds, nullptr, count);
+        }
+
+        //! Releases fully idle chunks back to the system; the first chunk is always kept
+        //! @return number of chunks released
+        std::size_t trim() {
+
+            std::lock_guard<std::mutex> lock(slabLock_);
+
+            // Detach the free list; concurrent allocations will now block on the slab lock
+            atomic_node<client>* list;
+            {
+                std::lock_guard<std::mutex> popLock(popLock_);
+                list = freeMem_.pop_all();
+            }
+
+            std::vector<std::size_t> freeCount(maxChunks_, 0);
+            for (atomic_node<client>* node = list; node != nullptr; node = node->next) {
+                ++freeCount[chunk_of(node)];
+            }
+
+            // Re-link and return slots of chunks that are still in use;
+            // a chunk is idle if every one of its slots is on the detached list
+            atomic_node<client>* first = nullptr;
+            atomic_node<client>* last = nullptr;
+
+            for (atomic_node<client>* node = list; node != nullptr; )
+            {
+                atomic_node<client>* next = node->next;
+
+                const std::size_t index = chunk_of(node);
+                if (index == 0 || freeCount[index] != chunkSize_)
+                {
+                    node->next = first;
+                    first = node;
+                    if (last == nullptr) {
+                        last = node;
+                    }
+                }
+
+                node = next;
+            }
+
+            std::vector<std::size_t> idle;
+            std::vector<atomic_node<client>*> idleChunks;
+            for (std::size_t i = 1; i < maxChunks_; ++i)
+            {
+                if (freeCount[i] == chunkSize_)
+                {
+                    idle.push_back(i);
+                    idleChunks.push_back(chunks_[i].load());
+                    chunks_[i].store(nullptr);
+                }
+            }
+
+            if (first != nullptr) {
+                freeMem_.push_list(first, last);
+            }
+
+            // A pop or lookup started before the list was detached may still read a released slot
+            while (readers_.load() != 0) {
+                std::this_thread::yield();
+            }
+
+            for (std::size_t i = 0; i != idle.size(); ++i)
+            {
+                const std::size_t index = idle[i];
+
+                // Handles to the released slots must not become valid again once the chunk is re-allocated
+                std::uint32_t generation = 0;
+                for (std::size_t j = 0; j != chunkSize_; ++j) {
+                    generation = std::max(generation, idleChunks[i][j].generation.load());
+                }
+
+                generations_[index] = generation + 1 != 0 ? generation + 1 : 1;
+
+                release(index, idleChunks[i]);
+                capacity_ -= chunkSize_;
+            }
+
+            return idle.size();
+        }
+
+        //! @get
+        //! @return number of worker threads
+        std::size_t get_worker_count() const {
+
+            std::lock_guard<std::mutex> lock(lock_);
+            return workerCount_;
+        }
+
+        //! Sets the number of worker threads, also while running; connections are kept
+        //! Retired workers finish the events of their last poll first; this call returns once they have exited
+        //! @param count    number of worker threads, at least 1
+        bool set_worker_count(const std::size_t count) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+            return resize(count);
+        }
+
+        //! Adds and retires workers from measured utilization while running; only valid while not running
+        //! Enables load tracking
+        //! @param scaling    worker bounds and utilization thresholds; a default-constructed value disables scaling
+        bool set_worker_scaling(const worker_scaling& scaling) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty()
+                || (scaling.maxWorkers != 0 && (scaling.minWorkers == 0
+                                                || scaling.minWorkers > scaling.maxWorkers
+                                                || scaling.scaleDown >= scaling.scaleUp
+                                                || scaling.interval == 0))) {
+                return false;
+            }
+
+            scaling_ = scaling;
+            trackLoad_ = trackLoad_ || scaling.maxWorkers != 0;
+            return true;
+        }
+
+        //! Enables strands, see post(); only valid while not running
+        //! Costs two atomic operations per event, as strand tasks take ownership of their connection like events do.
+        //! @param enable    true to enable strands
+        //! @return          false if running, or if the ready queue or its descriptor could not be created
+        bool set_strands(const bool enable) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty()) {
+                return false;
+            }
+
+            if (!enable)
+            {
+                strands_ = offload_ = mesh_ = false;
+                return true;
+            }
+
+            return enable_strands();
+        }
+
+        //! Runs task on the strand of a connection, on a worker thread that owns the connection meanwhile
+        //! Tasks of one connection run one at a time, in the order they were posted, and after the events being
+        //! processed; tasks of different connections run in parallel. Tasks posted from a callback run once the
+        //! callback returns. Tasks of a connection closed before they run are dropped. Requires set_strands().
+        //! @param h       connection handle
+        //! @param task    callable taking (handle, int sfd, Tctx&)
+        //! @return        false if strands are disabled, or the handle is stale
+        template <typename F>
+        bool post(const handle h, F task) {
+
+            if (!strands_) {
+                return false;
+            }
+
+            strand_task* node = static_cast<strand_task*>(resource_->allocate(sizeof(strand_task), alignof(strand_task)));
+            try {
+                new (node) strand_task(h, std::move(task));
+            }
+
+            catch (...)
+            {
+                resource_->deallocate(node, sizeof(strand_task), alignof(strand_task));
+                throw;
+            }
+
+            ++readers_;
+            client* cl;
+            if ((cl = lookup(h)) == nullptr)
+            {
+                --readers_;
+                destroy_task(node);
+                return false;
+            }
+
+            // Tasks are pushed onto a stack, the owner reverses the batch it takes
+            std::atomic<strand_task*>& strand = peer_of(cl).strand;
+            node->next = strand.load(std::memory_order_relaxed);
+            while (!strand.compare_exchange_weak(node->next, node, std::memory_order_release));
+
+            // The owner runs the tasks before leaving; a slot nobody owns is scheduled once onto the ready queue
+            std::uint32_t state = cl->flags.load(std::memory_order_relaxed);
+            std::uint32_t next;
+            do
+            {
+                // Closed; the task is dropped along with the strand
+                if ((state & (client::USED | client::EVICTED)) != client::USED) {
+                    break;
+                }
+
+                next = state | client::QUEUED;
+                if ((state & (client::BUSY | client::SCHEDULED)) == 0) {
+                    next |= client::SCHEDULED;
+                }
+            }
+            while (!cl->flags.compare_exchange_weak(state, next, std::memory_order_acq_rel));
+            --readers_;
+
+            if ((state & (client::USED | client::EVICTED | client::BUSY | client::SCHEDULED)) == client::USED)
+            {
+                // Each slot is on the ready queue at most once per generation
+                while (!ready_->push(h)) {
+                    std::this_thread::yield();
+                }
+
+                signal();
+            }
+
+            return true;
+        }
+
+        //! Creates the compute pool used by offload(), enables strands; only valid while not running
+        //! @param threadCount    number of compute threads
+        //! @param capacity       maximum number of offloaded calls whose work has not returned
+        //! @return               false if running, if either argument is 0, or if strands could not be enabled
+        bool set_offload(const std::size_t threadCount, const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty() || threadCount == 0 || capacity == 0 || !enable_strands()) {
+                return false;
+            }
+
+            // No more than capacity calls are in flight, so that submitting never fails
+            executor_.reset(new executor(threadCount, capacity, resource_));
+            offloadCap_ = capacity;
+            offload_ = true;
+            return true;
+        }
+
+        //! @get
+        //! @return number of offloaded calls whose work has not returned
+        std::size_t get_offloaded_count() const {
+
+            return offloaded_;
+        }
+
+        //! Runs work on the compute pool, then posts done to the strand of the connection
+        //! Meant to be called from a callback, so that CPU-heavy work does not hold up other connections;
+        //! done is dropped if the connection is closed before it runs, or if work throws. Requires set_offload().
+        //! @param h       connection handle
+        //! @param work    callable taking no arguments and returning a non-void result
+        //! @param done    callable taking (handle, int sfd, Tctx&, result)
+        //! @return        false if offloading is disabled, or too many calls are in flight
+        template <typename W, typename D>
+        bool offload(const handle h, W work, D done) {
+
+            if (!offload_) {
+                return false;
+            }
+
+            if (++offloaded_ > offloadCap_)
+            {
+                --offloaded_;
+                return false;
+            }
+
+            const bool ret = executor_->submit([this, h, work, done]() mutable {
+
+                // The exception stops at the compute thread, along with the completion
+                try {
+                    const typename std::result_of<W()>::type result = work();
+                    post(h, [done, result](const handle h, const int sfd, Tctx& ctx) mutable {
+                        done(h, sfd, ctx, result);
+                    });
+                }
+
+                catch (...) {}
+
+                --offloaded_;
+            });
+
+            if (!ret) {
+                --offloaded_;
+            }
+
+            return ret;
+        }
+
+        //! Creates the message mesh used by send(), enables strands; only valid while not running
+        //! Each worker gets one ring to each lane of connections, the connections whose slot index modulo the
+        //! number of lanes is equal; there is one lane per worker, or per maxWorkers if workers are scaled.
+        //! @param capacity    maximum number of queued messages from one worker to one lane
+        //! @return            false if running, if capacity is 0, or if strands could not be enabled
+        bool set_mesh(const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty() || capacity == 0 || !enable_strands()) {
+                return false;
+            }
+
+            meshCap_ = capacity;
+            mesh_ = true;
+            return true;
+        }
+
+        //! Sends message to a connection; the message is passed to the handler's
+        //! on_message(handle, int sfd, Tctx&, const char*, std::size_t) on a worker thread that owns the connection
+        //! meanwhile, or written to the connection if the handler does not implement it.
+        //! Messages from one thread to one connection are delivered in the order they were sent. Messages sent
+        //! from a worker go over its ring to the connection's lane, and are delivered in batches; messages sent
+        //! from any other thread, or from a worker started beyond the number of lanes, are posted to the strand of
+        //! the connection. Messages for a connection closed before delivery are dropped. Requires strands; without
+        //! set_mesh(), every message is posted to the strand.
+        //! If the ring is full, the sending worker delivers the messages of the lane itself, unless another worker is.
+        //! @param h       connection handle
+        //! @param data    message
+        //! @param size    message length
+        //! @return        false if strands are disabled, the ring is full, or the message was posted and the
+        //!                handle is stale
+        bool send(const handle h, const char* data, const std::size_t size) {
+
+            if (!strands_) {
+                return false;
+            }
+
+            const mesh_sender& sender = sender_of();
+            if (sender.pool != this)
+            {
+                const std::string message(data, size);
+                return post(h, [this, message](const handle h, const int sfd, Tctx& ctx) {
+                    detail::on_message(*static_cast<Tderiv*>(this), h, sfd, ctx, message.data(), message.size(),
+                                       detail::rank1());
+                });
+            }
+
+            // A full ring is drained by the sender itself, as the other workers may all be waiting on theirs
+            const std::size_t lane = h.index() % laneCount_;
+            spsc_queue<mesh_message>& ring = *rings_[sender.index * laneCount_ + lane];
+            if (!ring.push(mesh_message(h, std::string(data, size)))
+                && (!drain_lane(lane) || !ring.push(mesh_message(h, std::string(data, size))))) {
+                return false;
+            }
+
+            // One signal per lane until a worker starts draining it
+            if (!lanes_[lane].pending.exchange(true)) {
+                signal();
+            }
+
+            return true;
+        }
+
+        //! Creates the sequencer used by publish(), enables strands; only valid while not running
+        //! Messages published by any worker are passed to the handler's
+        //! on_sequenced(handle, const char*, std::size_t, bool endOfBatch) one at a time, in the order they were
+        //! published, on one thread started along with the workers; state used only there needs no locking.
+        //! Replies go back to the connections with send() or post().
+        //! @param capacity    maximum number of published messages not yet processed
+        //! @return            false if running, if capacity is 0, or if strands could not be enabled
+        bool set_sequencer(const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty() || capacity == 0 || !enable_strands()) {
+                return false;
+            }
+
+            sequencer_.reset(new sequencer<sequenced_message>(capacity, resource_));
+            return true;
+        }
+
+        //! Publishes message to the sequencer; waits while the sequencer is full. Requires set_sequencer().
+        //! Messages are copied into entries that keep their capacity, so steady traffic allocates nothing.
+        //! @param h       connection the message came from
+        //! @param data    message
+        //! @param size    message length
+        //! @return        false if the sequencer is disabled or stopped
+        bool publish(const handle h, const char* data, const std::size_t size) {
+
+            return sequencer_ && sequencer_->publish([h, data, size](sequenced_message& message) {
+                message.h = h;
+                message.data.assign(data, size);
+            });
+        }
+
+        //! Registers every worker with an epoch domain; only valid while not running
+        //! Each poll of a worker is a quiescent point, so callbacks may read objects of the domain, e.g. through
+        //! rcu_ptr::load(), without locks; the objects may not be kept past the callback. Objects retired by
+        //! writers can be deleted once every worker has polled again, see epoch_domain::reclaim().
+        //! @param domain    epoch domain, which outlives the pool; nullptr unregisters the workers
+        bool set_epoch_domain(epoch_domain* domain) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty()) {
+                return false;
+            }
+
+            epochs_ = domain;
+            return true;
+        }
+
+        //! Bounds the events a worker processes per poll; only valid while not running
+        //! Each worker processes at most batch connections per poll, and defers the events of the others to its
+        //! deque; the connections stay owned meanwhile, and further events are handed over as usual. A worker
+        //! processes its oldest deferred events first on its next poll, and a worker whose poll returns nothing
+        //! steals the oldest deferred events of the others, so that a burst taken by one worker is spread over
+        //! the idle ones. There is one deque per worker, or per maxWorkers if workers are scaled; workers started
+        //! beyond that never defer. If a deque is full, the events are processed at once. Cannot be combined with
+        //! priority classes, which queue the connections of a poll by class instead.
+        //! @param batch       maximum number of connections processed per poll; 0 disables stealing
+        //! @param capacity    maximum number of deferred connections per worker
+        //! @return            false if running, if priority classes are enabled, or if capacity is 0
+        bool set_work_stealing(const std::size_t batch, const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty() || (prioritized_ && batch != 0) || capacity == 0) {
+                return false;
+            }
+
+            stealing_ = batch != 0;
+            stealBatch_ = batch;
+            stealCap_ = capacity;
+            return true;
+        }
+
+        //! Starts instance
+        //!
+        void run() {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (threads_.empty())
+            {
+                sweepTime_.store(detail::clock_us());
+
+                if (scaling_.maxWorkers != 0) {
+                    workerCount_ = std::min(std::max(workerCount_, scaling_.minWorkers), scaling_.maxWorkers);
+                }
+
+                if (mesh_) {
+                    create_mesh();
+                }
+
+                if (stealing_) {
+                    create_deques();
+                }
+
+                if (sequencer_)
+                {
+                    sequencer_->run([this](sequenced_message& message, const bool endOfBatch) {
+                        detail::on_sequenced(*static_cast<Tderiv*>(this), message.h, message.data.data(),
+                                             message.data.size(), endOfBatch, detail::rank1());
+                    });
+                }
+
+                threadCount_.store(0);
+                for (std::size_t i = 0; i != workerCount_; ++i) {
+                    spawn();
+                }
+
+                if (scaling_.maxWorkers != 0)
+                {
+                    stopScaling_ = false;
+                    scaler_ = std::thread(&client_pool::scale, this);
+                }
+
+                if (offload_) {
+                    executor_->run();
+                }
+            }
+        }
+
+        //! Pins each worker thread to one CPU, from the next call to run()
+        //! @param pin    true to pin worker i to CPU (i % CPU count)
+        void set_worker_affinity(const bool pin) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+            pinWorkers_ = pin;
+        }
+
+        //! Stops running instance
+        //!
+        void stop() {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty())
+            {
+                halt();
+
+                // Maybe reset clients...
+                std::lock_guard<std::mutex> slabLock(slabLock_);
+                for (std::size_t i = 0; i != maxChunks_; ++i)
+                {
+                    atomic_node<client>* data = chunks_[i].load();
+                    if (data == nullptr) {
+                        continue;
+                    }
+
+                    for (std::size_t j = 0; j != chunkSize_; ++j)
+                    {
+                        client& ref = static_cast<client&>(data[j]);
+                        // Maybe reset client
+                        if (ref.sfd) {
+                            unuse(&ref);
+                        }
+                    }
+                }
+            }
+        }
+
+        //! Stops running instance, and queues every connection on the channel instead of closing it
+        //! The handler's on_hand_off(handle, int, Tctx&, std::string&), if implemented, is called for each connection
+        //! to export its state, at most handoff_channel::MAX_STATE bytes. Tasks posted to strands are dropped.
+        //! @param channel    connected handoff channel; the caller sends the end of the handoff
+        //! @return           number of connections queued; the others are closed
+        std::size_t hand_off(handoff_channel& channel) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!threads_.empty()) {
+                halt();
+            }
+
+            std::size_t count = 0;
+            std::string state;
+
+            std::lock_guard<std::mutex> slabLock(slabLock_);
+            for (std::size_t i = 0; i != maxChunks_; ++i)
+            {
+                atomic_node<client>* data = chunks_[i].load();
+                if (data == nullptr) {
+                    continue;
+                }
+
+                for (std::size_t j = 0; j != chunkSize_; ++j)
+                {
+                    client* cl = &data[j];
+                    if (cl->sfd == 0) {
+                        continue;
+                    }
+
+                    state.clear();
+                    detail::on_hand_off(*static_cast<Tderiv*>(this), cl->get_handle(), cl->sfd, context_of(cl), state,
+                                        detail::rank1());
+
+                    // The channel holds its own descriptor, this one is closed
+                    count += channel.add_client(cl->sfd, peer_of(cl).address, cl->received, state);
+                    unuse(cl);
+                }
+            }
+
+            return count;
+        }
+
+        //! Override this to handle out-of-band events
+        //! Handlers may instead implement on_oob(handle, int, char) to receive the connection handle,
+        //! or on_oob(handle, int, Tctx&, char) to also receive the connection context
+        //! @param sfd        triggered file descriptor
+        //! @param oobdata    oob byte
+        inline void on_oob(int sfd, char oobdata) {
+            (void)sfd;
+            (void)oobdata;
+        }
+
+        //! Override to handle input events
+        //! Handlers may instead implement on_input(handle, int, char*, int) to receive the connection handle,
+        //! or on_input(handle, int, Tctx&, char*, int) to also receive the connection context
+        //! @param sfd        triggered file descriptor
+        //! @param data       received data
+        //! @param datalen    received data length
+        inline void on_input(int sfd, char* data, int datalen) {
+            (void)sfd;
+            (void)data;
+            (void)datalen;
+        }
+
+        //! Override this to handle output-ready events
+        //! Handlers may instead implement on_write_ready(handle, int) to receive the connection handle,
+        //! or on_write_ready(handle, int, Tctx&) to also receive the connection context
+        //! @param sfd    triggered file descriptor
+        inline void on_write_ready(int sfd) {
+            (void)sfd;
+        }
+
+    private:
+
+        friend epoll<client_pool<Tderiv, Tctx> >;
+
+        // Uninitialized context, constructed in use() and destroyed in unuse()
+        typedef typename std::aligned_storage<sizeof(Tctx), alignof(Tctx)>::type context_storage;
+
+        // Task posted to a strand
+        struct strand_task {
+            handle h;
+            std::function<void(handle, int, Tctx&)> run;
+            strand_task* next;
+
+            //! ctor.
+            template <typename F>
+            strand_task(const handle h, F&& run) : h(h), run(std::forward<F>(run)), next(nullptr) {}
+        };
+
+        // Message sent over the mesh
+        struct mesh_message {
+            handle h;
+            std::string data;
+
+            //! ctor.
+            mesh_message() {}
+            mesh_message(const handle h, std::string&& data) : h(h), data(std::move(data)) {}
+        };
+
+        // Mesh lane; one worker at a time drains the rings of a lane
+        struct mesh_lane {
+            std::atomic<bool> busy; // Held by the draining worker
+            std::atomic<bool> pending; // Set by senders once messages are queued, cleared when draining starts
+            char pad[CACHE_LINE_SIZE - 2 * sizeof(std::atomic<bool>)];
+        };
+
+        // Message published to the sequencer
+        struct sequenced_message {
+            handle h;
+            std::string data;
+        };
+
+        // Ring a worker sends on; set while the worker runs
+        struct mesh_sender {
+            const client_pool* pool;
+            std::size_t index;
+        };
+
+        // Deque a worker defers events to; set while the worker runs
+        struct steal_worker {
+            const client_pool* pool;
+            std::size_t index;
+            std::size_t kept; // Slots processed since the latest poll
+            std::size_t victim; // Next deque to steal from
+        };
+
+        // Load a worker records between polls; reset when the thread polls for another pool
+        struct load_sample {
+            const client_pool* pool;
+            std::uint64_t previous; // Time of the worker's previous poll
+            int processed; // Events returned by the previous poll
+            std::uint64_t busy; // Time spent processing events since the worker last added to the totals
+            std::uint64_t polled; // Time spent running since then
+        };
+
+        // Slots a worker resumes on its next poll; set while the worker runs
+        struct read_queue {
+            const client_pool* pool;
+            std::vector<std::pair<client*, std::uint32_t> > queued; // Slots out of budget, with their generation
+            std::vector<std::pair<client*, std::uint32_t> > resumed; // Slots being resumed
+            client* yielded; // Slot that ran out of budget in the current dispatch
+            std::deque<std::pair<client*, std::uint32_t> > classes[MAX_PRIORITY_CLASSES]; // Slots waiting by class
+
+            //! ctor.
+            read_queue() : pool(nullptr), yielded(nullptr) {}
+        };
+
+        // Peer address and admission charges of a slot; cold storage, like the read buffer
+        struct peer_record {
+            peer_address address;
+            admission_ticket ticket;
+            // Buffer sizes given back once a shrunk connection is active again
+            int receiveBuffer;
+            int sendBuffer;
+            // Tasks posted to the strand, newest first
+            std::atomic<strand_task*> strand;
+            // Priority class
+            std::atomic<unsigned> priority;
+        };
+
+        // Service of a priority class; workers of every CPU add to it
+        struct priority_class {
+            std::atomic<std::uint64_t> served;
+            std::atomic<std::uint64_t> busy;
+            std::atomic<std::size_t> queued;
+            unsigned weight;
+            char pad[CACHE_LINE_SIZE - 2 * sizeof(std::atomic<std::uint64_t>) - sizeof(std::atomic<std::size_t>)
+                     - sizeof(unsigned)];
+
+            //! ctor.
+            priority_class() : served(0), busy(0), queued(0), weight(1) {}
+        };
+
+
+        // Applied to critical section when starting and stopping the running instance
+        mutable std::mutex lock_;
+        // Applied to critical section when growing or trimming the slab
+        mutable std::mutex slabLock_;
+        // Applied to critical section when popping from the free list
+        std::mutex popLock_;
+
+        // Memory
+        memory_resource* resource_; // General allocations
+        memory_resource* slabResource_; // Client slot allocations
+
+        admission admission_; // Per-source connection limits
+
+        // Threads
+        std::size_t workerCount_; // Total # of worker threads
+        std::size_t clientCap_; // Total # of allowed clients
+
+        // Slab
+        std::size_t chunkSize_; // # of client slots per chunk
+        std::size_t maxChunks_; // Maximum # of chunks
+        std::unique_ptr<std::atomic<atomic_node<client>*>[]> chunks_; // Allocated chunks, nullptr if not allocated
+        std::unique_ptr<client_buffer*[]> buffers_; // Read buffers of each allocated chunk
+        std::unique_ptr<context_storage*[]> contexts_; // Contexts of each allocated chunk
+        std::unique_ptr<peer_record*[]> peers_; // Peer records of each allocated chunk
+        std::unique_ptr<std::uint32_t[]> generations_; // First generation of each chunk's slots, survives trim()
+
+        std::atomic<std::size_t> clientCount_; // Current number of allocated clients
+        std::atomic<std::size_t> capacity_; // Current number of client slots
+        mutable std::atomic<std::size_t> readers_; // Current number of threads reading slots outside of an epoll event
+
+        atomic_stack<client> freeMem_; // Stack of allocated inactive clients
+
+        std::vector<std::thread, resource_allocator<std::thread> > threads_; // Workers
+        std::atomic<std::size_t> threadCount_; // Current number of running threads
+        bool pinWorkers_; // Pin each worker to one CPU
+
+        // Eviction
+        bool evictIdle_; // Evict idle connections when the pool is full
+        std::atomic<std::size_t> hand_; // Clock hand, next slot to inspect
+        std::atomic<std::size_t> evicted_; // # of evicted connections
+
+        // Load
+        bool trackLoad_; // Track worker lag and queue depth
+        std::atomic<std::uint64_t> lastPoll_; // Time any worker last polled, in microseconds
+        std::atomic<std::uint64_t> window_; // Start of the current lag window, in microseconds
+        std::atomic<std::uint64_t> cycle_; // Longest time between two polls of a worker in the current window
+        std::atomic<std::uint64_t> lastCycle_; // Same, in the previous window
+        std::atomic<std::size_t> depth_; // # of events returned by the latest poll
+
+        // Buffers
+        bool shrinkIdle_; // Shrink socket buffers of idle connections
+        bool restoreIdle_; // Give shrunk buffers their size back on the next event
+        std::uint64_t idleTime_; // Time without events before shrinking, in microseconds
+        int idleReceive_; // SO_RCVBUF of idle connections
+        int idleSend_; // SO_SNDBUF of idle connections
+        std::atomic<std::uint64_t> sweepTime_; // Time of the latest sweep step, in microseconds
+        std::atomic<std::size_t> sweepHand_; // Next slot to sweep
+        std::atomic<std::size_t> shrunk_; // # of connections with shrunk buffers
+
+        // Utilization
+        std::atomic<std::uint64_t> busy_; // Time workers spent processing events in the current window
+        std::atomic<std::uint64_t> polled_; // Time workers spent running in the current window
+        std::atomic<unsigned> utilization_; // busy_ / polled_ of the previous window, in percent
+
+        // Scaling
+        worker_scaling scaling_; // Worker bounds and thresholds; scaling is enabled if maxWorkers is set
+        std::thread scaler_; // Makes scaling decisions
+        bool stopScaling_;
+        std::mutex scaleLock_;
+        std::condition_variable scaleCond_;
+        std::vector<std::thread::id> exited_; // Workers that returned from wait(), not yet joined
+        std::mutex exitLock_;
+        std::condition_variable exitCond_;
+
+        // Strands
+        bool strands_; // Tasks can be posted to connections
+        std::unique_ptr<mpmc_queue<handle> > ready_; // Slots with tasks that nobody owns
+        int notifyfd_; // Eventfd, signalled once slots are put on the ready queue
+
+        // Offload
+        bool offload_; // Handlers may offload work to the compute pool
+        std::unique_ptr<executor> executor_; // Compute pool
+        std::atomic<std::size_t> offloaded_; // # of offloaded calls whose work has not returned
+        std::size_t offloadCap_; // Maximum # of offloaded calls whose work has not returned
+
+        // Mesh
+        bool mesh_; // Handlers may send messages to connections
+        std::size_t meshCap_; // Capacity of each ring
+        std::size_t laneCount_; // # of lanes, and of workers that send over rings
+        std::unique_ptr<std::unique_ptr<spsc_queue<mesh_message> >[]> rings_; // Ring of worker i to lane j at i * laneCount_ + j
+        std::unique_ptr<mesh_lane[]> lanes_;
+        std::unique_ptr<std::atomic<bool>[]> senders_; // Rings of sender i are taken by a running worker
+
+        // Sequencer
+        std::unique_ptr<sequencer<sequenced_message> > sequencer_; // Runs on_sequenced() on its own thread
+
+        // Reclamation
+        epoch_domain* epochs_; // Domain workers are registered with, nullptr if none
+
+        // Work stealing
+        bool stealing_; // Workers defer events beyond a batch per poll
+        std::size_t stealBatch_; // Slots a worker processes per poll
+        std::size_t stealCap_; // Capacity of each deque
+        std::size_t dequeCount_; // # of deques, and of workers that defer events
+        std::unique_ptr<std::unique_ptr<steal_deque<client*> >[]> deques_; // Owned slots with deferred events
+        std::unique_ptr<std::atomic<bool>[]> stealers_; // Deque i is taken by a running worker
+
+        // Read budget
+        std::size_t readBytes_; // Bytes read per event, 0 if unbounded
+        std::size_t readMessages_; // Calls to on_input() per event, 0 if unbounded
+        bool yielding_; // Slots out of budget are queued on their worker, rather than rearmed
+
+        // Priority classes
+        bool prioritized_; // Workers serve their slots by class
+        bool strictPriority_; // Only the first class with waiting slots is served per poll
+        std::size_t classCount_;
+        std::size_t defaultClass_; // Class of new connections
+        std::unique_ptr<priority_class[]> classes_;
+
+        // Epoll id of the ready queue descriptor; never a valid handle, as generation 0 is never used
+        static const std::uint64_t NOTIFY_ID = 1;
+        // Ready slots run per event, so that one worker does not hold on to a long queue
+        static const std::size_t READY_BATCH = 64;
+        // Messages taken from each ring per event
+        static const std::size_t MESH_BATCH = 64;
+        // Returned by leave() along with handed over events if tasks were posted; above any epoll event bit
+        static const int TASKS_QUEUED = 1 << 30;
+
+        // Resolution of lastPoll_; keeps spinning workers from writing the shared value on every poll
+        static const std::uint64_t LAG_RESOLUTION = 100;
+        // Lag is the longest poll cycle over one to two windows of this length, in microseconds
+        static const std::uint64_t LAG_WINDOW = 100000;
+        // Time between two sweep steps, in microseconds; each step sweeps its share of a pass that takes idleTime
+        static const std::uint64_t SWEEP_INTERVAL = 10000;
+        // Workers add their busy and polled time to the shared totals once they have run this long, in microseconds
+        static const std::uint64_t UTILIZATION_FLUSH = 10000;
+
+        /*! Stops the scaler, compute pool and workers; connections are left open. The lock must be held
+         */
+        void halt() {
+
+            // The scaler does not resize while the lock is held
+            if (scaler_.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> scaleLock(scaleLock_);
+                    stopScaling_ = true;
+                }
+
+                scaleCond_.notify_all();
+                scaler_.join();
+            }
+
+            // Offloaded work still runs; completions posted before the workers exit are processed
+            if (offload_) {
+                executor_->stop();
+            }
+
+            // Published messages are processed, and their replies delivered, while the workers still run;
+            // workers publishing from now on are refused
+            if (sequencer_) {
+                sequencer_->stop();
+            }
+
+            // Master thread initiates the shutdown daisy-chain
+            epoll<client_pool<Tderiv, Tctx> >::close();
+            for (std::size_t i = 0; i != threads_.size(); ++i) {
+                threads_[i].join();
+            }
+
+            threads_.clear();
+
+            // Messages not delivered yet are dropped
+            if (mesh_)
+            {
+                mesh_message message;
+                for (std::size_t i = 0; i != laneCount_ * laneCount_; ++i) {
+                    while (rings_[i]->pop(message));
+                }
+
+                for (std::size_t i = 0; i != laneCount_; ++i) {
+                    lanes_[i].pending.store(false);
+                }
+            }
+
+            // The connections of the remaining scheduled slots are closed or handed off, along with their strands
+            if (strands_)
+            {
+                handle h;
+                while (ready_->pop(h));
+            }
+
+            std::lock_guard<std::mutex> exitLock(exitLock_);
+            exited_.clear();
+        }
+
+        /*! Admits connection and takes a slot for it; the connection is not yet watched
+         */
+        client* admit(const int sfd, const peer_address& peer) {
+
+            admission_ticket ticket;
+            if (!admission_.acquire(peer, ticket))
+                return nullptr;
+
+            client* cl;
+            if ((cl = use(sfd)) == nullptr)
+            {
+                admission_.release(ticket);
+                return nullptr;
+            }
+
+            peer_record& record = peer_of(cl);
+            record.address = peer;
+            record.ticket = ticket;
+            record.priority.store(static_cast<unsigned>(defaultClass_), std::memory_order_relaxed);
+            return cl;
+        }
+
+        /*! Starts watching an admitted connection; on failure, gives the slot back and leaves the socket to the
+         *! caller
+         */
+        bool attach(client* const cl) {
+
+            if (epoll<client_pool>::add(cl) == -1)
+            {
+                recycle(cl);
+                return false;
+            }
+
+            return true;
+        }
+
+        /*! Starts a worker; the lock must be held
+         */
+        void spawn() {
+
+            const std::size_t index = threads_.size();
+
+            ++threadCount_;
+            threads_.emplace_back([this] {
+
+                epoch_domain::participant*& participant = participant_of();
+                if (epochs_ != nullptr) {
+                    participant = epochs_->join();
+                }
+
+                // Takes the rings of the first free sender, if any
+                mesh_sender& sender = sender_of();
+                for (std::size_t i = 0; mesh_ && i != laneCount_ && sender.pool != this; ++i)
+                {
+                    if (!senders_[i].exchange(true, std::memory_order_acquire))
+                    {
+                        sender.pool = this;
+                        sender.index = i;
+                    }
+                }
+
+                // Takes the first free deque, if any
+                steal_worker& worker = worker_of();
+                for (std::size_t i = 0; stealing_ && i != dequeCount_ && worker.pool != this; ++i)
+                {
+                    if (!stealers_[i].exchange(true, std::memory_order_acquire))
+                    {
+                        worker.pool = this;
+                        worker.index = i;
+                        worker.kept = 0;
+                        worker.victim = i + 1;
+                    }
+                }
+
+                read_queue& reads = read_queue_of();
+                if (yielding_ || prioritized_) {
+                    reads.pool = this;
+                }
+
+                epoll<client_pool<Tderiv, Tctx> >::wait(threadCount_);
+
+                // Queued slots are resumed once more; those still out of budget are rearmed, for other workers
+                if (reads.pool == this)
+                {
+                    reads.pool = nullptr;
+                    run_yielded();
+                    run_classes(true);
+                }
+
+                // Deferred events are processed before the deque is given up
+                if (worker.pool == this)
+                {
+                    client* cl;
+                    while (deques_[worker.index]->pop(cl)) {
+                        resume(cl);
+                    }
+
+                    worker.pool = nullptr;
+                    stealers_[worker.index].store(false, std::memory_order_release);
+                }
+
+                if (sender.pool == this)
+                {
+                    sender.pool = nullptr;
+                    senders_[sender.index].store(false, std::memory_order_release);
+                }
+
+                if (epochs_ != nullptr)
+                {
+                    epochs_->leave(participant);
+                    participant = nullptr;
+                }
+
+                std::lock_guard<std::mutex> exitLock(exitLock_);
+                exited_.push_back(std::this_thread::get_id());
+                exitCond_.notify_all();
+            });
+
+            // Worker i runs on CPU i, wrapping around
+            if (pinWorkers_)
+            {
+                const std::size_t cpuCount = std::max(1u, std::thread::hardware_concurrency());
+                detail::pin_thread(threads_.back().native_handle(), index % cpuCount, cpuCount);
+            }
+        }
+
+        /*! Starts or retires workers; the lock must be held
+         */
+        bool resize(const std::size_t count) {
+
+            if (count == 0) {
+                return false;
+            }
+
+            if (!threads_.empty())
+            {
+                while (threads_.size() < count) {
+                    spawn();
+                }
+
+                if (threads_.size() > count)
+                {
+                    // Any worker may pick up a retire message; the ones that exit are joined
+                    const std::size_t retiring = threads_.size() - count;
+                    for (std::size_t i = 0; i != retiring; ++i) {
+                        epoll<client_pool<Tderiv, Tctx> >::retire();
+                    }
+
+                    std::unique_lock<std::mutex> exitLock(exitLock_);
+                    exitCond_.wait(exitLock, [this, retiring] { return exited_.size() >= retiring; });
+
+                    for (std::size_t i = 0; i != exited_.size(); ++i)
+                    {
+                        for (std::size_t j = 0; j != threads_.size(); ++j)
+                        {
+                            if (threads_[j].get_id() == exited_[i])
+                            {
+                                threads_[j].join();
+                                threads_.erase(threads_.begin() + j);
+                                break;
+                            }
+                        }
+                    }
+
+                    exited_.clear();
+
+                    // Remaining workers keep one CPU each
+                    if (pinWorkers_)
+                    {
+                        const std::size_t cpuCount = std::max(1u, std::thread::hardware_concurrency());
+                        for (std::size_t i = 0; i != threads_.size(); ++i) {
+                            detail::pin_thread(threads_[i].native_handle(), i % cpuCount, cpuCount);
+                        }
+                    }
+                }
+            }
+
+            workerCount_ = count;
+            return true;
+        }
+
+        /*! Scaler thread; samples utilization every window, and adds or retires one worker per interval
+         */
+        void scale() {
+
+            std::uint64_t sum = 0;
+            std::uint64_t samples = 0;
+            std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now()
+                + std::chrono::microseconds(scaling_.interval);
+
+            // Copied, as the duration constructor takes its count by reference
+            const std::uint64_t window = LAG_WINDOW;
+
+            std::unique_lock<std::mutex> scaleLock(scaleLock_);
+            while (!scaleCond_.wait_for(scaleLock, std::chrono::microseconds(window), [this] { return stopScaling_; }))
+            {
+                sum += utilization_.load(std::memory_order_relaxed);
+                ++samples;
+
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if (now < next) {
+                    continue;
+                }
+
+                next = now + std::chrono::microseconds(scaling_.interval);
+
+                const std::uint64_t utilization = sum / samples;
+                sum = samples = 0;
+
+                // stop() holds the lock while waiting for this thread
+                std::unique_lock<std::mutex> lock(lock_, std::try_to_lock);
+                if (!lock.owns_lock()) {
+                    continue;
+                }
+
+                const std::size_t count = threads_.size();
+                if (utilization > scaling_.scaleUp && count < scaling_.maxWorkers) {
+                    resize(count + 1);
+                }
+
+                else if (utilization < scaling_.scaleDown && count > scaling_.minWorkers) {
+                    resize(count - 1);
+                }
+            }
+        }
+
+        /*! Called on epoll event, casts epoll data value to correct type before passing it to process()
+         *! The handle keeps the generation the event was registered for, checked again once the slot is owned
+         */
+        handle cast(epoll_data data) {
+            return handle(data.u64);
+        }
+
+        /*! Returns the slot referenced by handle, nullptr if the handle is stale
+         *! The caller counts itself in readers_ until it owns the slot, or is done with it, as trim() may release
+         *! the chunk of a free slot meanwhile
+         */
+        client* lookup(const handle h) const {
+
+            const std::size_t index = h.index();
+            if (index >= clientCap_) {
+                return nullptr;
+            }
+
+            atomic_node<client>* chunk;
+            if ((chunk = chunks_[index / chunkSize_].load()) == nullptr) {
+                return nullptr;
+            }
+
+            client* cl = &chunk[index % chunkSize_];
+            return cl->generation.load(std::memory_order_acquire) == h.generation() ? cl : nullptr;
+        }
+
+        /*! Called on epoll event to processes triggered file descriptor
+         */
+        inline void process(const handle h, const int flags);
+
+        /*! Called by workers after every poll, records load and sweeps idle connections
+         */
+        void on_wait(const int nevents) {
+
+            // Objects read while processing the previous poll are not held anymore
+            if (epochs_ != nullptr) {
+                epochs_->quiescent(*participant_of());
+            }
+
+            if (!trackLoad_ && !shrinkIdle_ && !stealing_ && !yielding_ && !prioritized_) {
+                return;
+            }
+
+            const std::uint64_t now = trackLoad_ || shrinkIdle_ ? detail::clock_us() : 0;
+
+            // Deferred events are processed after the clock is read, so that their time counts as busy
+            std::size_t resumed = yielding_ ? run_yielded() : 0;
+            if (prioritized_) {
+                resumed += run_classes(false);
+            }
+
+            if (stealing_) {
+                resumed += run_deferred(nevents);
+            }
+
+            if (trackLoad_) {
+                track(now, nevents + static_cast<int>(resumed));
+            }
+
+            if (shrinkIdle_) {
+                sweep(now);
+            }
+        }
+
+        /*! Records load
+         */
+        void track(const std::uint64_t now, const int nevents) {
+
+            load_sample& sample = load_sample_of();
+            if (sample.pool != this)
+            {
+                const load_sample reset = { this, 0, 0, 0, 0 };
+                sample = reset;
+            }
+
+            if (now - lastPoll_.load(std::memory_order_relaxed) >= LAG_RESOLUTION) {
+                lastPoll_.store(now, std::memory_order_relaxed);
+            }
+
+            const std::uint64_t cycle = sample.previous != 0 ? now - sample.previous : 0;
+            sample.previous = now;
+
+            // The time since the previous poll went to processing its events
+            sample.polled += cycle;
+            sample.busy += sample.processed != 0 ? cycle : 0;
+            sample.processed = nevents;
+
+            if (sample.polled >= UTILIZATION_FLUSH)
+            {
+                busy_.fetch_add(sample.busy, std::memory_order_relaxed);
+                polled_.fetch_add(sample.polled, std::memory_order_relaxed);
+                sample.busy = sample.polled = 0;
+            }
+
+            // Idle workers only write once per window
+            std::uint64_t start = window_.load(std::memory_order_relaxed);
+            if (now - start >= LAG_WINDOW && window_.compare_exchange_strong(start, now))
+            {
+                lastCycle_.store(cycle_.exchange(cycle), std::memory_order_relaxed);
+
+                // A long callback may be counted in a later window
+                const std::uint64_t total = polled_.exchange(0, std::memory_order_relaxed);
+                const std::uint64_t share = total != 0 ? busy_.exchange(0, std::memory_order_relaxed) * 100 / total : 0;
+                utilization_.store(static_cast<unsigned>(std::min<std::uint64_t>(share, 100)), std::memory_order_relaxed);
+            }
+
+            else if (cycle > cycle_.load(std::memory_order_relaxed)) {
+                cycle_.store(cycle, std::memory_order_relaxed);
+            }
+
+            // Idle polls only write once, to reset the depth
+            if (nevents != 0 || depth_.load(std::memory_order_relaxed) != 0) {
+                depth_.store(static_cast<std::size_t>(nevents), std::memory_order_relaxed);
+            }
+        }
+
+        /*! Sweeps the next share of slots; shrinks the buffers of connections that were not active since the
+         *! previous pass, and clears the activity bit of the others
+         */
+        void sweep(const std::uint64_t now) {
+
+            std::uint64_t last = sweepTime_.load(std::memory_order_relaxed);
+            if (now - last < SWEEP_INTERVAL || !sweepTime_.compare_exchange_strong(last, now)) {
+                return;
+            }
+
+            // A late step catches up, at most one pass
+            const std::uint64_t elapsed = std::min(now - last, idleTime_);
+            const std::size_t count = std::max<std::size_t>(1, static_cast<std::size_t>(clientCap_ * elapsed / idleTime_));
+            const std::size_t first = sweepHand_.fetch_add(count);
+
+            ++readers_;
+            for (std::size_t step = 0; step != count; ++step)
+            {
+                const std::size_t index = (first + step) % clientCap_;
+
+                atomic_node<client>* chunk;
+                if ((chunk = chunks_[index / chunkSize_].load()) == nullptr) {
+                    continue;
+                }
+
+                client* cl = &chunk[index % chunkSize_];
+
+                std::uint32_t state = cl->flags.load(std::memory_order_relaxed);
+                if ((state & (client::USED | client::BUSY | client::EVICTED | client::SHRUNK)) != client::USED) {
+                    continue;
+                }
+
+                if (state & client::TOUCHED) {
+                    cl->flags.compare_exchange_strong(state, state & ~static_cast<std::uint32_t>(client::TOUCHED));
+                }
+
+                // Owned like an event, so that neither workers nor eviction close the connection meanwhile
+                else if (cl->flags.compare_exchange_strong(state, state | client::BUSY, std::memory_order_acquire))
+                {
+                    const std::uint32_t generation = cl->generation.load(std::memory_order_relaxed);
+                    shrink(cl);
+
+                    // Events that arrived meanwhile are processed here; the slot cannot be trimmed while owned
+                    int flags;
+                    if ((flags = leave(cl)) != 0)
+                    {
+                        --readers_;
+                        drain(cl, flags, generation);
+                        ++readers_;
+                    }
+                }
+            }
+            --readers_;
+        }
+
+        /*! Shrinks socket buffers of owned slot, keeping their size for restore() if enabled
+         */
+        void shrink(client* const cl) {
+
+            if (restoreIdle_)
+            {
+                socket_memory mem;
+                if (endpoint_memory(cl->sfd, &mem) == -1) {
+                    return;
+                }
+
+                // The kernel reports doubled sizes
+                peer_record& record = peer_of(cl);
+                record.receiveBuffer = idleReceive_ != 0 ? static_cast<int>(mem.receiveLimit / 2) : 0;
+                record.sendBuffer = idleSend_ != 0 ? static_cast<int>(mem.sendLimit / 2) : 0;
+            }
+
+            endpoint_set_buffers(cl->sfd, idleReceive_, idleSend_);
+            cl->flags.fetch_or(client::SHRUNK);
+            ++shrunk_;
+        }
+
+        /*! Gives socket buffers of owned slot their size back
+         */
+        void restore(client* const cl) {
+
+            const peer_record& record = peer_of(cl);
+            endpoint_set_buffers(cl->sfd, record.receiveBuffer, record.sendBuffer);
+            cl->flags.fetch_and(~static_cast<std::uint32_t>(client::SHRUNK));
+            --shrunk_;
+        }
+
+        /*! Processes triggered file descriptor
+         */
+        inline void dispatch(client* const cl, const int flags);
+
+        /*! Creates the ready queue and its descriptor; the lock must be held
+         */
+        bool enable_strands() {
+
+            if (notifyfd_ == -1)
+            {
+                if ((notifyfd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+                    return false;
+                }
+
+                if (epoll<client_pool<Tderiv, Tctx> >::watch(notifyfd_, NOTIFY_ID) == -1)
+                {
+                    endpoint_close(notifyfd_);
+                    notifyfd_ = -1;
+                    return false;
+                }
+            }
+
+            // A slot is scheduled once per generation; twice the slots leaves room for stale entries
+            if (!ready_) {
+                ready_.reset(new mpmc_queue<handle>(2 * clientCap_, resource_));
+            }
+
+            strands_ = true;
+            return true;
+        }
+
+        /*! Runs the tasks posted to the strand of owned slot; stops if the connection is closed by a task
+         */
+        void run_tasks(client* const cl, const std::uint32_t generation) {
+
+            strand_task* list = peer_of(cl).strand.exchange(nullptr, std::memory_order_acquire);
+
+            // Oldest first
+            strand_task* ordered = nullptr;
+            while (list != nullptr)
+            {
+                strand_task* next = list->next;
+                list->next = ordered;
+                ordered = list;
+                list = next;
+            }
+
+            while (ordered != nullptr)
+            {
+                strand_task* next = ordered->next;
+
+                // Tasks posted to an earlier connection of the slot are dropped
+                if (ordered->h.generation() == generation
+                    && cl->generation.load(std::memory_order_acquire) == generation) {
+                    ordered->run(ordered->h, cl->sfd, context_of(cl));
+                }
+
+                destroy_task(ordered);
+                ordered = next;
+            }
+        }
+
+        /*! Drops the tasks posted to the strand of slot
+         */
+        void clear_tasks(peer_record& record) {
+
+            strand_task* list = record.strand.exchange(nullptr, std::memory_order_acquire);
+            while (list != nullptr)
+            {
+                strand_task* next = list->next;
+                destroy_task(list);
+                list = next;
+            }
+        }
+
+        /*! Destroys strand task
+         */
+        void destroy_task(strand_task* const node) {
+
+            node->~strand_task();
+            resource_->deallocate(node, sizeof(strand_task), alignof(strand_task));
+        }
+
+        /*! Signals the workers that slots are put on the ready queue
+         */
+        void signal() {
+
+            const std::uint64_t value = 1;
+            if (::write(notifyfd_, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+                perror("client_pool::signal");
+            }
+        }
+
+        /*! Runs the strands of slots on the ready queue, each on its owned slot
+         */
+        inline void run_ready();
+
+        /*! Returns the mesh sender of the calling thread
+         */
+        static mesh_sender& sender_of() {
+
+            static thread_local mesh_sender sender = { nullptr, 0 };
+            return sender;
+        }
+
+        /*! Returns the work-stealing state of the calling thread
+         */
+        static steal_worker& worker_of() {
+
+            static thread_local steal_worker worker = { nullptr, 0, 0, 0 };
+            return worker;
+        }
+
+        /*! Creates one deque per worker; the lock must be held
+         */
+        void create_deques() {
+
+            dequeCount_ = std::max<std::size_t>(std::max(workerCount_, scaling_.maxWorkers), 1);
+            deques_.reset(new std::unique_ptr<steal_deque<client*> >[dequeCount_]);
+            stealers_.reset(new std::atomic<bool>[dequeCount_]);
+            for (std::size_t i = 0; i != dequeCount_; ++i)
+            {
+                deques_[i].reset(new steal_deque<client*>(stealCap_, resource_));
+                stealers_[i].store(false);
+            }
+        }
+
+        /*! Processes a batch of deferred events, the worker's own or, if it is idle, stolen from other workers
+         *! @return number of slots processed
+         */
+        inline std::size_t run_deferred(const int nevents);
+
+        /*! Returns the load sample of the calling thread
+         */
+        static load_sample& load_sample_of() {
+
+            static thread_local load_sample sample = { nullptr, 0, 0, 0, 0 };
+            return sample;
+        }
+
+        /*! Returns the read queue of the calling thread
+         */
+        static read_queue& read_queue_of() {
+
+            static thread_local read_queue queue;
+            return queue;
+        }
+
+        /*! Checks the read budget of an event
+         *! @return true if the bytes or messages read reach their bound
+         */
+        bool over_budget(const std::size_t bytes, const std::size_t messages) const {
+            return (readBytes_ != 0 && bytes >= readBytes_) || (readMessages_ != 0 && messages >= readMessages_);
+        }
+
+        /*! Stops reading from owned slot out of budget; it is resumed with events after the other connections
+         */
+        inline void yield(client* const cl, const int events);
+
+        /*! Resumes the slots that ran out of budget since the previous poll
+         *! @return number of slots resumed
+         */
+        inline std::size_t run_yielded();
+
+        /*! Queues owned slot by priority class, with events parked on the slot; the calling worker serves it
+         *! @return false if the slot could not be queued
+         */
+        inline bool enqueue(client* const cl, const int events);
+
+        /*! Serves the queued slots of each class, up to its weight, or every queued slot
+         *! @return number of slots resumed
+         */
+        inline std::size_t run_classes(const bool all);
+
+        /*! Processes the events deferred or handed over on owned slot; gives up ownership if there are none
+         */
+        void resume(client* const cl) {
+
+            const std::uint32_t generation = cl->generation.load(std::memory_order_acquire);
+            const int flags = leave(cl);
+            if (flags != 0) {
+                drain(cl, flags, generation);
+            }
+        }
+
+        /*! Returns the epoch domain record of the calling worker
+         */
+        static epoch_domain::participant*& participant_of() {
+
+            static thread_local epoch_domain::participant* participant = nullptr;
+            return participant;
+        }
+
+        /*! Creates one ring per worker and lane; the lock must be held
+         */
+        void create_mesh() {
+
+            laneCount_ = std::max<std::size_t>(std::max(workerCount_, scaling_.maxWorkers), 1);
+            rings_.reset(new std::unique_ptr<spsc_queue<mesh_message> >[laneCount_ * laneCount_]);
+            for (std::size_t i = 0; i != laneCount_ * laneCount_; ++i) {
+                rings_[i].reset(new spsc_queue<mesh_message>(meshCap_, resource_));
+            }
+
+            lanes_.reset(new mesh_lane[laneCount_]);
+            senders_.reset(new std::atomic<bool>[laneCount_]);
+            for (std::size_t i = 0; i != laneCount_; ++i)
+            {
+                lanes_[i].busy.store(false);
+                lanes_[i].pending.store(false);
+                senders_[i].store(false);
+            }
+        }
+
+        /*! Drains the rings of every pending lane no other worker is draining
+         */
+        inline void run_mesh();
+
+        /*! Delivers a batch of messages from each ring of lane, unless another worker is draining it
+         *! @return true if the lane was drained empty
+         */
+        inline bool drain_lane(const std::size_t lane);
+
+        /*! Delivers message on its owned slot; posts it to the strand if another worker owns the slot
+         */
+        inline void deliver(mesh_message& message);
+
+        /*! Processes events of owned slot, and events handed over meanwhile, then gives up ownership
+         */
+        inline void drain(client* const cl, int flags, const std::uint32_t generation);
+
+        /*! Takes ownership of slot for processing
+         *! If another worker owns the slot, hands it the events instead
+         *! @param generation    generation of the connection the events belong to
+         *! @return              false if the events are handed over, if the slot is being evicted, or if the
+         *!                      connection was closed since the events were polled
+         */
+        bool enter(client* const cl, const int flags, const std::uint32_t generation) {
+
+            std::uint32_t state = cl->flags.load(std::memory_order_acquire);
+            while (true)
+            {
+                // The slot may have been released, and reused, by eviction or by its owner since the poll
+                if ((state & (client::USED | client::EVICTED)) != client::USED
+                    || cl->generation.load(std::memory_order_acquire) != generation) {
+                    return false;
+                }
+
+                if (state & client::BUSY)
+                {
+                    if (cl->flags.compare_exchange_weak(state, state | (static_cast<std::uint32_t>(flags) << client::PENDING_SHIFT),
+                                                        std::memory_order_acq_rel)) {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                if (cl->flags.compare_exchange_weak(state, state | client::BUSY | client::REFERENCED | client::TOUCHED,
+                                                    std::memory_order_acquire))
+                {
+                    // Released and reused between the check and the exchange; the events of the new connection
+                    // handed over meanwhile are processed, the stale ones are dropped
+                    if (cl->generation.load(std::memory_order_acquire) != generation)
+                    {
+                        resume(cl);
+                        return false;
+                    }
+
+                    return true;
+                }
+            }
+        }
+
+        /*! Gives up ownership of slot, unless events were handed over or tasks were posted meanwhile
+         *! @return handed over events, with TASKS_QUEUED if tasks were posted; 0 if ownership was given up
+         */
+        int leave(client* const cl) {
+
+            std::uint32_t state = cl->flags.load(std::memory_order_relaxed);
+            while (true)
+            {
+                const std::uint32_t pending = state >> client::PENDING_SHIFT;
+                const bool queued = (state & client::QUEUED) != 0;
+                const std::uint32_t next = pending != 0 || queued
+                    ? state & ((1u << client::PENDING_SHIFT) - 1) & ~static_cast<std::uint32_t>(client::QUEUED)
+                    : state & ~static_cast<std::uint32_t>(client::BUSY);
+
+                if (cl->flags.compare_exchange_weak(state, next, std::memory_order_acq_rel)) {
+                    return static_cast<int>(pending) | (queued ? TASKS_QUEUED : 0);
+                }
+            }
+        }
+
+        /*! Evicts the least recently active connection; a clock sweep gives recently active connections
+         *! a second chance, and skips connections that are being processed
+         *! @return false if no connection could be evicted
+         */
+        bool evict() {
+
+            client* victim = nullptr;
+
+            ++readers_;
+            for (std::size_t step = 0; step != 2 * clientCap_ && victim == nullptr; ++step)
+            {
+                const std::size_t index = hand_++ % clientCap_;
+
+                atomic_node<client>* chunk;
+                if ((chunk = chunks_[index / chunkSize_].load()) == nullptr) {
+                    continue;
+                }
+
+                client* cl = &chunk[index % chunkSize_];
+
+                std::uint32_t state = cl->flags.load(std::memory_order_relaxed);
+                if ((state & (client::USED | client::BUSY | client::EVICTED)) != client::USED) {
+                    continue;
+                }
+
+                if (state & client::REFERENCED) {
+                    cl->flags.compare_exchange_strong(state, state & ~static_cast<std::uint32_t>(client::REFERENCED));
+                }
+
+                else if (cl->flags.compare_exchange_strong(state, state | client::EVICTED, std::memory_order_acquire)) {
+                    victim = cl;
+                }
+            }
+            --readers_;
+
+            // In use, so its chunk cannot be trimmed
+            if (victim == nullptr) {
+                return false;
+            }
+
+            unuse(victim);
+            ++evicted_;
+            return true;
+        }
+
+        /*! Returns index of the chunk containing the given slot
+         */
+        std::size_t chunk_of(const atomic_node<client>* node) const {
+
+            for (std::size_t i = 0; i != maxChunks_; ++i)
+            {
+                const atomic_node<client>* chunk = chunks_[i].load();
+                if (chunk != nullptr && node >= chunk && node < chunk + chunkSize_) {
+                    return i;
+                }
+            }
+
+            return maxChunks_;
+        }
+
+        /*! Returns read buffer of slot
+         */
+        client_buffer& buffer_of(const client* const cl) {
+            return buffers_[cl->index / chunkSize_][cl->index % chunkSize_];
+        }
+
+        /*! Returns context of slot
+         */
+        Tctx& context_of(const client* const cl) {
+            return *reinterpret_cast<Tctx*>(&contexts_[cl->index / chunkSize_][cl->index % chunkSize_]);
+        }
+
+        /*! Returns peer record of slot
+         */
+        peer_record& peer_of(const client* const cl) const {
+            return peers_[cl->index / chunkSize_][cl->index % chunkSize_];
+        }
+
+        /*! Called on epoll event, prefetches the slot of an upcoming event
+         */
+        void prefetch(epoll_data data) const {
+
+            const std::size_t index = handle(data.u64).index();
+            if (index < clientCap_)
+            {
+                const atomic_node<client>* chunk = chunks_[index / chunkSize_].load(std::memory_order_relaxed);
+                if (chunk != nullptr) {
+                    __builtin_prefetch(&chunk[index % chunkSize_]);
+                }
+            }
+        }
+
+        /*! Allocates one chunk-sized array from the slab resource
+         */
+        template <typename T>
+        T* create(const std::size_t alignment) {
+            return static_cast<T*>(slabResource_->allocate(sizeof(T) * chunkSize_, alignment));
+        }
+
+        /*! Deallocates chunk-sized array, ignores nullptr
+         */
+        template <typename T>
+        void destroy(T* const mem, const std::size_t alignment) {
+
+            if (mem != nullptr) {
+                slabResource_->deallocate(mem, sizeof(T) * chunkSize_, alignment);
+            }
+        }
+
+        /*! Allocates chunk and pushes its slots to the free list
+         */
+        bool allocate(const std::size_t index) {
+
+            atomic_node<client>* chunk = nullptr;
+            client_buffer* buffers = nullptr;
+            context_storage* contexts = nullptr;
+            peer_record* peers = nullptr;
+
+            try
+            {
+                chunk = create<atomic_node<client> >(CACHE_LINE_SIZE);
+                buffers = create<client_buffer>(alignof(client_buffer));
+                contexts = create<context_storage>(alignof(context_storage));
+                peers = create<peer_record>(alignof(peer_record));
+            }
+
+            catch (std::bad_alloc&)
+            {
+                destroy(chunk, CACHE_LINE_SIZE);
+                destroy(buffers, alignof(client_buffer));
+                destroy(contexts, alignof(context_storage));
+                return false;
+            }
+
+            link(index, chunk, buffers, contexts, peers);
+            return true;
+        }
+
+        /*! Frees chunk memory; the chunk must already be unlinked from the free list
+         */
+        void release(const std::size_t index, atomic_node<client>* chunk) {
+
+            // Tasks posted to connections that closed before they ran
+            for (std::size_t i = 0; i != chunkSize_; ++i) {
+                clear_tasks(peers_[index][i]);
+            }
+
+            destroy(chunk, CACHE_LINE_SIZE);
+            destroy(buffers_[index], alignof(client_buffer));
+            destroy(contexts_[index], alignof(context_storage));
+            destroy(peers_[index], alignof(peer_record));
+            buffers_[index] = nullptr;
+            contexts_[index] = nullptr;
+            peers_[index] = nullptr;
+        }
+
+        /*! Stores chunk and pushes its slots to the free list
+         */
+        void link(const std::size_t index,
+                  atomic_node<client>* chunk,
+                  client_buffer* buffers,
+                  context_storage* contexts,
+                  peer_record* peers) {
+
+            for (std::size_t i = 0; i + 1 < chunkSize_; ++i) {
+                new (&chunk[i]) atomic_node<client>(&chunk[i + 1]);
+            }
+
+            new (&chunk[chunkSize_ - 1]) atomic_node<client>(nullptr);
+
+            for (std::size_t i = 0; i != chunkSize_; ++i)
+            {
+                chunk[i].index = static_cast<std::uint32_t>(index * chunkSize_ + i);
+                chunk[i].generation.store(generations_[index], std::memory_order_relaxed);
+                new (&peers[i].strand) std::atomic<strand_task*>(nullptr);
+                new (&peers[i].priority) std::atomic<unsigned>(0);
+            }
+
+            buffers_[index] = buffers;
+            contexts_[index] = contexts;
+            peers_[index] = peers;
+            chunks_[index].store(chunk);
+            capacity_ += chunkSize_;
+
+            freeMem_.push_list(&chunk[0], &chunk[chunkSize_ - 1]);
+        }
+
+        /*! Pops free slot, guarded against concurrent trim()
+         *! The free list has no ABA tag, and acceptor threads allocate concurrently, so pops are serialized
+         */
+        client* pop() {
+
+            std::lock_guard<std::mutex> lock(popLock_);
+
+            ++readers_;
+            client* mem = freeMem_.pop();
+            --readers_;
+            return mem;
+        }
+
+        /*! Allocates a new chunk if the slab is exhausted and under its hard limit
+         */
+        client* grow() {
+
+            std::lock_guard<std::mutex> lock(slabLock_);
+
+            // Slots may have been returned while waiting for the lock
+            client* mem;
+            if ((mem = pop()) != nullptr) {
+                return mem;
+            }
+
+            for (std::size_t i = 0; i != maxChunks_; ++i)
+            {
+                if (chunks_[i].load() == nullptr) {
+                    return allocate(i) ? pop() : nullptr;
+                }
+            }
+
+            return nullptr;
+        }
+
+        /*! Closes socket and stores client to unused queue
+         */
+        void unuse(client* const cl) {
+
+            epoll<client_pool>::remove(cl->sfd);
+            endpoint_close(cl->sfd);
+            recycle(cl);
+        }
+
+        /*! Stores client to unused queue, along with its admission charges; the socket is left open
+         */
+        void recycle(client* const cl) {
+
+            cl->sfd = 0;
+
+            context_of(cl).~Tctx();
+
+            admission_.release(peer_of(cl).ticket);
+            peer_of(cl).ticket = admission_ticket();
+
+            if (strands_) {
+                clear_tasks(peer_of(cl));
+            }
+
+            if (cl->flags.load(std::memory_order_relaxed) & client::SHRUNK) {
+                --shrunk_;
+            }
+
+            // Invalidate outstanding handles
+            std::uint32_t generation = cl->generation.load(std::memory_order_relaxed) + 1;
+            cl->generation.store(generation != 0 ? generation : 1, std::memory_order_release);
+            cl->flags.store(0, std::memory_order_release);
+
+            freeMem_.push(cl);
+            --clientCount_;
+        }
+
+        /*! Allocates new client
+         */
+        client* use(const int sfd) {
+
+            client* mem;
+            if ((mem = pop()) == nullptr
+                && (mem = grow()) == nullptr)
+            {
+                // Another thread may take the released slot first
+                for (int attempt = 0; mem == nullptr; ++attempt)
+                {
+                    if (!evictIdle_ || attempt == EVICT_ATTEMPTS || !evict()) {
+                        return nullptr;
+                    }
+
+                    mem = pop();
+                }
+            }
+
+            try {
+                new (&context_of(mem)) Tctx();
+            }
+
+            catch (...)
+            {
+                freeMem_.push(mem);
+                return nullptr;
+            }
+
+            ++clientCount_;
+            mem->sfd = sfd;
+            mem->received = 0;
+            // New connections get a second chance, like active ones
+            mem->flags.store(client::USED | client::REFERENCED | client::TOUCHED, std::memory_order_release);
+            return mem;
+        }
+
+        /*! EPOLLOUT
+         */
+        inline void handle_epollout(client* const);
+        /*! EPOLLIN
+         */
+        inline void handle_epollin(client* const);
+        /*! EPOLLPRI
+         */
+        inline void handle_epollpri(client* const);
+    };
+
+
+    /*! Processes epoll events
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::process(const handle h, int flags)
+    {
+        // Slots are put on the ready queue
+        if (h.id == NOTIFY_ID)
+        {
+            run_ready();
+
+            if (mesh_) {
+                run_mesh();
+            }
+
+            return;
+        }
+
+        // Stale event, the slot has been released
+        ++readers_;
+        client* const cl = lookup(h);
+        if (cl == nullptr)
+        {
+            --readers_;
+            return;
+        }
+
+        // Only this thread releases the slot
+        if (!evictIdle_ && !shrinkIdle_ && !strands_ && !stealing_ && !yielding_ && !prioritized_)
+        {
+            --readers_;
+            dispatch(cl, flags);
+            return;
+        }
+
+        // Slots are owned while processed, so that evicting and sweeping threads leave them alone
+        const std::uint32_t generation = h.generation();
+        const bool entered = enter(cl, flags, generation);
+        --readers_;
+
+        if (!entered) {
+            return;
+        }
+
+        // Served by class, once the events of the poll are all queued
+        if (prioritized_ && read_queue_of().pool == this && enqueue(cl, flags)) {
+            return;
+        }
+
+        // Beyond the batch, the events are parked on the owned slot, as if handed over, until the slot is resumed
+        if (stealing_)
+        {
+            steal_worker& worker = worker_of();
+            if (worker.pool == this && worker.kept == stealBatch_)
+            {
+                cl->flags.fetch_or(static_cast<std::uint32_t>(flags) << client::PENDING_SHIFT, std::memory_order_relaxed);
+                if (deques_[worker.index]->push(cl)) {
+                    return;
+                }
+
+                resume(cl);
+                return;
+            }
+
+            ++worker.kept;
+        }
+
+        drain(cl, flags, generation);
+    }
+
+    /*! Processes a batch of deferred events
+     */
+    template <typename Tderiv, typename Tctx>
+    std::size_t client_pool<Tderiv, Tctx>::run_deferred(const int nevents)
+    {
+        steal_worker& worker = worker_of();
+        if (worker.pool != this) {
+            return 0;
+        }
+
+        worker.kept = 0;
+
+        // Oldest first, so that a worker kept busy by new events still gets to its earliest deferred ones
+        client* cl;
+        steal_deque<client*>& own = *deques_[worker.index];
+        while (worker.kept != stealBatch_ && own.steal(cl))
+        {
+            ++worker.kept;
+            resume(cl);
+        }
+
+        // Idle worker takes over deferred events of the others, starting after the deque it last stole from
+        for (std::size_t i = 0; nevents == 0 && worker.kept == 0 && i != dequeCount_; ++i)
+        {
+            const std::size_t victim = worker.victim++ % dequeCount_;
+            if (victim == worker.index) {
+                continue;
+            }
+
+            steal_deque<client*>& other = *deques_[victim];
+            while (worker.kept != stealBatch_ && other.steal(cl))
+            {
+                ++worker.kept;
+                resume(cl);
+            }
+
+            // The same worker is robbed first next time, while it has events left
+            if (worker.kept != 0)
+            {
+                --worker.victim;
+                break;
+            }
+        }
+
+        return worker.kept;
+    }
+
+    /*! Processes events of owned slot, and events handed over meanwhile, then gives up ownership
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::drain(client* const cl, int flags, const std::uint32_t generation)
+    {
+        do
+        {
+            // Active again; only the owner changes this bit
+            if (restoreIdle_ && (cl->flags.load(std::memory_order_relaxed) & client::SHRUNK)) {
+                restore(cl);
+            }
+
+            if ((flags & ~TASKS_QUEUED) != 0) {
+                dispatch(cl, flags & ~TASKS_QUEUED);
+            }
+
+            // Out of read budget; the slot stays owned until the worker resumes it
+            read_queue& reads = read_queue_of();
+            const bool yielded = reads.yielded == cl;
+            reads.yielded = nullptr;
+
+            // Released while processing
+            if (cl->generation.load(std::memory_order_acquire) != generation) {
+                return;
+            }
+
+            // Tasks run after the events
+            if (flags & TASKS_QUEUED)
+            {
+                run_tasks(cl, generation);
+
+                if (cl->generation.load(std::memory_order_acquire) != generation) {
+                    return;
+                }
+            }
+
+            if (yielded) {
+                return;
+            }
+        }
+        while ((flags = leave(cl)) != 0);
+    }
+
+    /*! Stops reading from owned slot out of budget
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::yield(client* const cl, const int events)
+    {
+        read_queue& reads = read_queue_of();
+
+        // The events are parked on the slot, as if handed over, and processed again when it is resumed
+        if (reads.pool == this && yielding_)
+        {
+            // Waits behind the other slots of its class
+            if (prioritized_)
+            {
+                if (!enqueue(cl, events)) {
+                    epoll<client_pool>::rearm(cl);
+                    return;
+                }
+
+                reads.yielded = cl;
+                return;
+            }
+
+            try {
+                reads.queued.push_back(std::make_pair(cl, cl->generation.load(std::memory_order_relaxed)));
+            }
+
+            catch (...)
+            {
+                epoll<client_pool>::rearm(cl);
+                return;
+            }
+
+            cl->flags.fetch_or(static_cast<std::uint32_t>(events) << client::PENDING_SHIFT, std::memory_order_relaxed);
+            reads.yielded = cl;
+            return;
+        }
+
+        // Input left is reported again, to any worker, once the other ready connections are polled
+        epoll<client_pool>::rearm(cl);
+    }
+
+    /*! Resumes the slots that ran out of budget
+     */
+    template <typename Tderiv, typename Tctx>
+    std::size_t client_pool<Tderiv, Tctx>::run_yielded()
+    {
+        read_queue& reads = read_queue_of();
+        if (reads.queued.empty()) {
+            return 0;
+        }
+
+        // Slots out of budget again are resumed on the next poll
+        reads.resumed.swap(reads.queued);
+        for (std::size_t i = 0; i != reads.resumed.size(); ++i)
+        {
+            // Owned since it was queued, unless the connection was closed meanwhile
+            client* const cl = reads.resumed[i].first;
+            if (cl->generation.load(std::memory_order_acquire) == reads.resumed[i].second) {
+                resume(cl);
+            }
+        }
+
+        const std::size_t count = reads.resumed.size();
+        reads.resumed.clear();
+        return count;
+    }
+
+    /*! Queues owned slot by priority class
+     */
+    template <typename Tderiv, typename Tctx>
+    bool client_pool<Tderiv, Tctx>::enqueue(client* const cl, const int events)
+    {
+        const unsigned priority = peer_of(cl).priority.load(std::memory_order_relaxed);
+        try {
+            read_queue_of().classes[priority].push_back(std::make_pair(cl, cl->generation.load(std::memory_order_relaxed)));
+        }
+
+        catch (...) {
+            return false;
+        }
+
+        cl->flags.fetch_or(static_cast<std::uint32_t>(events) << client::PENDING_SHIFT, std::memory_order_relaxed);
+        classes_[priority].queued.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*! Serves the queued slots of each class
+     */
+    template <typename Tderiv, typename Tctx>
+    std::size_t client_pool<Tderiv, Tctx>::run_classes(const bool all)
+    {
+        read_queue& reads = read_queue_of();
+
+        std::size_t total = 0;
+        for (std::size_t priority = 0; priority != classCount_; ++priority)
+        {
+            std::deque<std::pair<client*, std::uint32_t> >& queue = reads.classes[priority];
+            if (queue.empty()) {
+                continue;
+            }
+
+            // Slots queued again while served, e.g. out of budget, wait for the next poll
+            const std::size_t count = all ? queue.size() : std::min<std::size_t>(queue.size(), classes_[priority].weight);
+            const std::uint64_t start = detail::clock_us();
+            for (std::size_t i = 0; i != count; ++i)
+            {
+                const std::pair<client*, std::uint32_t> entry = queue.front();
+                queue.pop_front();
+
+                // Owned since it was queued, unless the connection was closed meanwhile
+                if (entry.first->generation.load(std::memory_order_acquire) == entry.second) {
+                    resume(entry.first);
+                }
+            }
+
+            priority_class& c = classes_[priority];
+            c.served.fetch_add(count, std::memory_order_relaxed);
+            c.busy.fetch_add(detail::clock_us() - start, std::memory_order_relaxed);
+            c.queued.fetch_sub(count, std::memory_order_relaxed);
+            total += count;
+
+            // Lower classes wait until every higher one is served
+            if (strictPriority_ && !all) {
+                break;
+            }
+        }
+
+        return total;
+    }
+
+    /*! Runs the strands of ready slots
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::run_ready()
+    {
+        // Slots scheduled after this read signal again
+        std::uint64_t value;
+        if (::read(notifyfd_, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+            perror("client_pool::run_ready");
+        }
+
+        handle h;
+        for (std::size_t i = 0; i != READY_BATCH && ready_->pop(h); ++i)
+        {
+            ++readers_;
+            client* cl = lookup(h);
+
+            // Owned like an event; while owned, the slot can be neither released nor trimmed.
+            // If another worker owns the slot, it runs the tasks before leaving.
+            std::uint32_t state = cl != nullptr ? cl->flags.load(std::memory_order_relaxed) : 0;
+            std::uint32_t next;
+            do
+            {
+                if ((state & (client::USED | client::EVICTED | client::SCHEDULED)) != (client::USED | client::SCHEDULED)) {
+                    break;
+                }
+
+                next = state & ~static_cast<std::uint32_t>(client::SCHEDULED);
+                if ((state & client::BUSY) == 0) {
+                    next |= client::BUSY | client::REFERENCED | client::TOUCHED;
+                }
+            }
+            while (!cl->flags.compare_exchange_weak(state, next, std::memory_order_acq_rel));
+            --readers_;
+
+            if ((state & (client::USED | client::EVICTED | client::SCHEDULED | client::BUSY))
+                != (client::USED | client::SCHEDULED)) {
+                continue;
+            }
+
+            // The slot may have been reused before it was owned; then its own tasks are run
+            const std::uint32_t generation = cl->generation.load(std::memory_order_acquire);
+            drain(cl, 0, generation);
+        }
+
+        if (ready_->get_size() != 0) {
+            signal();
+        }
+    }
+
+    /*! Drains the rings of every pending lane no other worker is draining
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::run_mesh()
+    {
+        // A sender that finds the lane pending does not signal; the draining worker checks again once done
+        for (std::size_t lane = 0; lane != laneCount_; ++lane) {
+            while (lanes_[lane].pending.load() && drain_lane(lane));
+        }
+    }
+
+    /*! Delivers a batch of messages from each ring of lane
+     */
+    template <typename Tderiv, typename Tctx>
+    bool client_pool<Tderiv, Tctx>::drain_lane(const std::size_t lane)
+    {
+        mesh_lane& l = lanes_[lane];
+        if (l.busy.exchange(true, std::memory_order_acquire)) {
+            return false;
+        }
+
+        l.pending.exchange(false);
+
+        bool more = false;
+        for (std::size_t sender = 0; sender != laneCount_; ++sender)
+        {
+            spsc_queue<mesh_message>& ring = *rings_[sender * laneCount_ + lane];
+
+            mesh_message message;
+            for (std::size_t i = 0; i != MESH_BATCH && ring.pop(message); ++i) {
+                deliver(message);
+            }
+
+            more = more || ring.get_size() != 0;
+        }
+
+        l.busy.store(false);
+
+        // Left for another event, so that one worker does not hold on to a busy lane
+        if (more && !l.pending.exchange(true)) {
+            signal();
+        }
+
+        return !more;
+    }
+
+    /*! Delivers message on its owned slot
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::deliver(mesh_message& message)
+    {
+        ++readers_;
+        client* cl = lookup(message.h);
+
+        // Owned like an event; a slot owned by another worker gets the message on its strand
+        std::uint32_t state = cl != nullptr ? cl->flags.load(std::memory_order_relaxed) : 0;
+        while ((state & (client::USED | client::EVICTED | client::BUSY)) == client::USED
+               && !cl->flags.compare_exchange_weak(state, state | client::BUSY | client::REFERENCED | client::TOUCHED,
+                                                   std::memory_order_acquire));
+        --readers_;
+
+        // Closed; the message is dropped
+        if ((state & (client::USED | client::EVICTED)) != client::USED) {
+            return;
+        }
+
+        if (state & client::BUSY)
+        {
+            const std::string data(std::move(message.data));
+            post(message.h, [this, data](const handle h, const int sfd, Tctx& ctx) {
+                detail::on_message(*static_cast<Tderiv*>(this), h, sfd, ctx, data.data(), data.size(), detail::rank1());
+            });
+
+            return;
+        }
+
+        // The slot may have been reused before it was owned; then the message is dropped.
+        // Tasks posted earlier run first, among them messages of this ring that found the slot owned.
+        const std::uint32_t generation = cl->generation.load(std::memory_order_acquire);
+        if (generation == message.h.generation())
+        {
+            run_tasks(cl, generation);
+
+            if (cl->generation.load(std::memory_order_acquire) == generation) {
+                detail::on_message(*static_cast<Tderiv*>(this), message.h, cl->sfd, context_of(cl), message.data.data(),
+                                   message.data.size(), detail::rank1());
+            }
+        }
+
+        drain(cl, 0, generation);
+    }
+
+    /*! Processes epoll events
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::dispatch(client* const client, int flags)
+    {
+        switch (flags)
         {
             case EPOLLHUP:
             case EPOLLHUP | EPOLLOUT:
 
-            case EPOLLRDHUP:
-            case EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
+            case EPOLLRDHUP:
+            case EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
+            {
+                unuse(client);
+                break;
+            }
+
+            case EPOLLIN:
+            case EPOLLIN | EPOLLHUP:
+            case EPOLLIN | EPOLLHUP | EPOLLOUT: // ignore EPOLLOUT
+
+            case EPOLLIN | EPOLLRDHUP:
+            case EPOLLIN | EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
+            {
+                handle_epollin(client); // Also processes hangup (on 0-byte read)
+                break;
+            }
+
+            case EPOLLPRI:
+            case EPOLLPRI | EPOLLHUP:
+            case EPOLLPRI | EPOLLHUP | EPOLLOUT: // ignore EPOLLOUT
+
+            case EPOLLPRI | EPOLLRDHUP:
+            case EPOLLPRI | EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
+            {
+                handle_epollpri(client); // Also process hangup (on 0-byte read)
+                break;
+            }
+
+            case EPOLLIN | EPOLLPRI:
+            case EPOLLIN | EPOLLPRI | EPOLLHUP:
+            case EPOLLIN | EPOLLPRI | EPOLLHUP | EPOLLOUT: // ignore EPOLLOUT
+
+            case EPOLLIN | EPOLLPRI | EPOLLRDHUP:
+            case EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
+            {
+                handle_epollpri(client); // Also processes hangup (on 0-byte read)
+                break;
+            }
+
+            case EPOLLOUT:
+            {
+                handle_epollout(client);
+                break;
+            }
+
+            case EPOLLIN | EPOLLOUT:
+            {
+                handle_epollin(client);
+                handle_epollout(client);
+                break;
+            }
+
+            case EPOLLPRI | EPOLLOUT:
+            {
+                handle_epollpri(client);
+                handle_epollout(client);
+                break;
+            }
+
+            case EPOLLIN | EPOLLPRI | EPOLLOUT:
+            {
+                handle_epollpri(client);
+                handle_epollout(client);
+                break;
+            }
+
+            default:
+            {
+                // Have error, close the socket
+                if ((flags & EPOLLERR) == EPOLLERR) {
+                    unuse(client);
+                }
+            }
+        }
+    }
+
+    /*! EPOLLOUT
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::handle_epollout(client* const cl)
+    {
+        detail::on_write_ready(*static_cast<Tderiv*>(this), cl->get_handle(), cl->sfd, context_of(cl), detail::rank2());
+    }
+
+    /*! EPOLLIN
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::handle_epollin(client* const cl)
+    {
+        char* const buff = buffer_of(cl).data;
+
+        // Read budget of this event
+        std::size_t bytes = 0;
+        std::size_t messages = 0;
+
+        while (true)
+        {
+            int nbytes;
+            switch (nbytes = endpoint_read(cl->sfd, buff, static_cast<int>(cl->size)))
+            {
+                case -1:
+                {
+                    if (errno != EAGAIN)
+                        unuse(cl); // Have actual error - done with client
+                    else
+                        epoll<client_pool>::rearm(cl);
+                    return;
+                }
+
+                case 0:
+                {
+                    unuse(cl); // Disconnection - done with client
+                    return;
+                }
+
+                // Have data to process...
+                default:
+                {
+                    cl->received += nbytes;
+                    detail::on_input(*static_cast<Tderiv*>(this), cl->get_handle(), cl->sfd, context_of(cl), buff, nbytes, detail::rank2());
+
+                    if (over_budget(bytes += nbytes, ++messages))
+                    {
+                        yield(cl, EPOLLIN);
+                        return;
+                    }
+
+                    break;
+                }
+            }
+        }
+    }
+
+    /*! EPOLLPRI
+     */
+    template <typename Tderiv, typename Tctx>
+    void client_pool<Tderiv, Tctx>::handle_epollpri(client* const cl)
+    {
+        char* const buff = buffer_of(cl).data;
+
+        // Read budget of this event
+        std::size_t bytes = 0;
+        std::size_t messages = 0;
+
+        while (true)
+        {
+            int mark;
+            if (::ioctl(cl->sfd, SIOCATMARK, &mark) == -1)
+            {
+                unuse(cl); // Have actual error - done with client
+                break;
+            }
+
+            else
+            {
+                if (mark)
+                {
+                    char oobdata;
+                    if (endpoint_read_oob(cl->sfd, &oobdata) != -1)
+                        detail::on_oob(*static_cast<Tderiv*>(this), cl->get_handle(), cl->sfd, context_of(cl), oobdata, detail::rank2());
+
+                    else
+                    {
+                        unuse(cl); // Have actual error - done with client
+                        break;
+                    }
+                }
+            }
+
+            int nbytes;
+            switch ((nbytes = endpoint_read(cl->sfd, buff, static_cast<int>(cl->size))))
+            {
+                case -1:
+                {
+                    if (errno != EAGAIN)
+                        unuse(cl); // Have actual error - done with client
+                    else
+                        epoll<client_pool>::rearm(cl);
+                    return;
+                }
+
+                case 0:
+                {
+                    unuse(cl); // Disconnection - done with client
+                    return;
+                }
+
+                // Have data to process...
+                default:
+                {
+                    cl->received += nbytes;
+                    detail::on_input(*static_cast<Tderiv*>(this), cl->get_handle(), cl->sfd, context_of(cl), buff, nbytes, detail::rank2());
+
+                    if (over_budget(bytes += nbytes, ++messages))
+                    {
+                        yield(cl, EPOLLIN | EPOLLPRI);
+                        return;
+                    }
+
+                    break;
+                }
+            }
+        }
+    }
+
+    //! @class acceptor
+    /*! waits on a set of listener sockets on one thread, and hands connection requests to its owner
+     */
+    template <typename Towner>
+    class acceptor : public server_pool_base, public epoll<acceptor<Towner> > {
+    public:
+
+        //! ctor.
+        //! @param owner       server pool that processes connection requests
+        //! @param resource    memory resource used for event arrays
+        acceptor(Towner& owner, memory_resource* resource) : epoll<acceptor<Towner> >(resource)
+                                                           , owner_(owner)
+                                                           , threadCount_(0) {}
+
+        //! Adds listener socket
+        //! @param sfd         file descriptor
+        //! @param quickAck    true if connections accepted on the listener are set to TCP_QUICKACK
+        bool add(const int sfd, const bool quickAck = false) {
+
+            // The flag travels with every event, so that accepting needs no lookup
+            const int ret = epoll<acceptor<Towner> >::add(sfd, quickAck ? 1 : 0);
+            return ret == 0;
+        }
+
+        //! Waits for connection requests on the calling thread, until stop() is called
+        //!
+        void run() {
+
+            threadCount_ = 1;
+            epoll<acceptor<Towner> >::wait(threadCount_);
+        }
+
+        //! Stops running instance
+        //!
+        void stop() {
+
+            epoll<acceptor<Towner> >::close();
+        }
+
+    private:
+
+        friend epoll<acceptor<Towner> >;
+
+        Towner&                  owner_;
+        std::atomic<std::size_t> threadCount_; // Current number of running threads
+
+        /*! Called on epoll event, casts epoll data value to correct type before passing it to process()
+         */
+        std::uint64_t cast(epoll_data data) {
+            return data.u64;
+        }
+
+        /*! Called on epoll event; listener events need no prefetching
+         */
+        void prefetch(epoll_data) const {}
+
+        /*! Called after every poll, lets the owner resume accepting
+         */
+        void on_wait(int) {
+            owner_.on_wait();
+        }
+
+        /*! Called on epoll event to handle connection requests
+         */
+        void process(const std::uint64_t data, const int flags) {
+            owner_.process(static_cast<int>(static_cast<std::uint32_t>(data)), (data >> 32) != 0, flags);
+        }
+    };
+
+    //! @struct accept_throttle
+    /* thresholds of worker load beyond which the server backs off accepting connections; 0 disables a threshold
+     */
+    struct accept_throttle {
+
+        // Time since any worker last polled for events, in microseconds
+        std::uint64_t maxLag;
+        // Events returned by a worker poll
+        std::size_t maxDepth;
+        // Connections accepted and parked while backing off; any further connections stay in the kernel backlog
+        std::size_t pendingCap;
+
+        //! ctor.
+        accept_throttle() : maxLag(0), maxDepth(0), pendingCap(0) {}
+    };
+
+    //! @class server_pool
+    /*! encapsulates event handling for multiple server sockets and their clients
+     *! connection requests are accepted on one or more acceptor threads, each with its own epoll instance
+     */
+    template <typename T>
+    class server_pool {
+    public:
+
+        //! dtor.
+        //!
+        ~server_pool() {
+
+            for (std::size_t i = 0; i != listeners_.size(); ++i) {
+                endpoint_close(listeners_[i]);
+            }
+
+            for (std::size_t i = 0; i != paths_.size(); ++i) {
+                ::unlink(paths_[i].c_str());
+            }
+
+            for (std::size_t i = 0; i != pending_.size(); ++i) {
+                endpoint_close(pending_[i].first);
+            }
+        }
+
+        //! ctor.
+        //! @param workerCount     number of client handler thread
+        //! @param clientCap    maximum number of clients
+        server_pool(const std::size_t workerCount,
+                    const std::size_t clientCap) : clientPool_(workerCount, clientCap)
+                                                 , resource_(get_heap_resource())
+                                                 , listenerCount_(0)
+                                                 , steering_(false)
+                                                 , throttling_(false)
+                                                 , backlogged_(false)
+                                                 , accepting_(false)
+                                                 , running_(false) {
+            set_acceptor_count(1);
+        }
+
+        //! ctor.
+        //! @param workerCount    number of client handler thread
+        //! @param clientCap      maximum number of clients
+        //! @param chunkSize      number of client slots allocated at a time
+        server_pool(const std::size_t workerCount,
+                    const std::size_t clientCap,
+                    const std::size_t chunkSize) : clientPool_(workerCount, clientCap, chunkSize)
+                                                 , resource_(get_heap_resource())
+                                                 , listenerCount_(0)
+                                                 , steering_(false)
+                                                 , throttling_(false)
+                                                 , backlogged_(false)
+                                                 , accepting_(false)
+                                                 , running_(false) {
+            set_acceptor_count(1);
+        }
+
+        //! ctor.
+        //! @param workerCount    number of client handler thread
+        //! @param clientCap      maximum number of clients
+        //! @param chunkSize      number of client slots allocated at a time
+        //! @param resource       memory resource used by both the server and the client pool; nullptr for the default
+        server_pool(const std::size_t workerCount,
+                    const std::size_t clientCap,
+                    const std::size_t chunkSize,
+                    memory_resource* resource) : clientPool_(workerCount, clientCap, chunkSize, resource)
+                                               , resource_(resource != nullptr ? resource : get_heap_resource())
+                                               , listenerCount_(0)
+                                               , steering_(false)
+                                               , throttling_(false)
+                                               , backlogged_(false)
+                                               , accepting_(false)
+                                               , running_(false) {
+            set_acceptor_count(1);
+        }
+
+        ::size_t get_active_count() const {
+            return clientPool_.get_active_count();
+        }
+
+        //! @get
+        //! @return true from the time run() starts the server until it is stopped; stop() has no effect before
+        bool is_running() const {
+            return running_.load();
+        }
+
+        //! @get
+        //! @return number of worker threads
+        std::size_t get_worker_count() const {
+            return clientPool_.get_worker_count();
+        }
+
+        //! Sets the number of worker threads, also while running; connections are kept
+        //! @param count    number of worker threads, at least 1
+        bool set_worker_count(const std::size_t count) {
+            return clientPool_.set_worker_count(count);
+        }
+
+        //! @get
+        //! Requires load tracking, enabled by set_load_tracking(), set_accept_throttle() or set_worker_scaling()
+        //! @return share of time workers spent processing events over the last window, in percent
+        unsigned get_utilization() const {
+            return clientPool_.get_utilization();
+        }
+
+        //! Enables tracking of worker load; only valid while not running
+        //! @param track    true to track worker lag, queue depth and utilization
+        bool set_load_tracking(const bool track) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_load_tracking(track);
+        }
+
+        //! Adds and retires workers from measured utilization while running; only valid while not running
+        //! @param scaling    worker bounds and utilization thresholds; a default-constructed value disables scaling
+        bool set_worker_scaling(const worker_scaling& scaling) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_worker_scaling(scaling);
+        }
+
+        //! @get
+        //! @return number of acceptor threads
+        std::size_t get_acceptor_count() const {
+
+            std::lock_guard<std::mutex> lock(lock_);
+            return acceptors_.size();
+        }
+
+        //! Sets the number of acceptor threads; only valid before any listener socket is added
+        //! @param count    number of acceptor threads; each bound port gets one SO_REUSEPORT listener per acceptor
+        bool set_acceptor_count(const std::size_t count) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (count == 0 || running_ || listenerCount_ != 0) {
+                return false;
+            }
+
+            acceptors_.clear();
+            for (std::size_t i = 0; i != count; ++i) {
+                acceptors_.emplace_back(new acceptor<server_pool<T> >(*this, resource_));
+            }
+
+            return true;
+        }
+
+        //! Sets the per-source connection limits applied to accepted connections; only valid while not running
+        //! @param policy    limits; a default-constructed policy admits everyone
+        bool set_admission_policy(const admission_policy& policy) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_admission_policy(policy);
+        }
+
+        //! Sets the worker load beyond which connections are no longer handed to the client pool; only valid while
+        //! not running. While workers are overloaded, up to pendingCap connections are accepted and parked, and any
+        //! further ones are left in the kernel backlog; parked connections are handed over first once load drops.
+        //! @param throttle    load thresholds; a default-constructed value disables throttling
+        bool set_accept_throttle(const accept_throttle& throttle) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            // Load tracking may also be on for worker scaling
+            const bool throttling = throttle.maxLag != 0 || throttle.maxDepth != 0;
+            if (running_ || (throttling && !clientPool_.set_load_tracking(true))) {
+                return false;
+            }
+
+            throttle_ = throttle;
+            throttling_ = throttling;
+            return true;
+        }
+
+        //! @get
+        //! @return number of accepted connections waiting for worker load to drop
+        std::size_t get_pending_count() const {
+
+            std::lock_guard<std::mutex> lock(pendingLock_);
+            return pending_.size();
+        }
+
+        //! Enables eviction of idle connections when the client pool is full; only valid while not running
+        //! @param evict    true to close the least recently active connection to admit a new one
+        bool set_idle_eviction(const bool evict) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_idle_eviction(evict);
+        }
+
+        //! Shrinks the kernel socket buffers of idle connections, see client_pool::set_buffer_shrinking(); only
+        //! valid while not running
+        //! @param idleTime         microseconds without events before shrinking, 0 disables
+        //! @param receiveBuffer    SO_RCVBUF of idle connections, 0 leaves the size unchanged
+        //! @param sendBuffer       SO_SNDBUF of idle connections, 0 leaves the size unchanged
+        //! @param restore          true to give shrunk buffers their previous size back on the next event
+        bool set_buffer_shrinking(const std::uint64_t idleTime,
+                                  const int receiveBuffer,
+                                  const int sendBuffer,
+                                  const bool restore = false) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_buffer_shrinking(idleTime, receiveBuffer, sendBuffer, restore);
+        }
+
+        //! Bounds the input read per event, see client_pool::set_read_budget(); only valid while not running
+        //! @param bytes           bytes read per event, 0 for no bound
+        //! @param messages        calls to on_input() per event, 0 for no bound
+        //! @param levelTriggered  true to watch connections level-triggered
+        bool set_read_budget(const std::size_t bytes, const std::size_t messages, const bool levelTriggered) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_read_budget(bytes, messages, levelTriggered);
+        }
+
+        //! Schedules connections by priority class, see client_pool::set_priority_classes(); only valid while not
+        //! running, and without work stealing
+        //! @param weights         connections served per poll for each class, class 0 first; empty disables classes
+        //! @param strict          true for strict priority, class 0 highest
+        //! @param defaultClass    class of new connections
+        bool set_priority_classes(const std::vector<unsigned>& weights, const bool strict, const std::size_t defaultClass) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_priority_classes(weights, strict, defaultClass);
+        }
+
+        //! Moves a connection to another priority class, see client_pool::set_priority()
+        //! @param h           connection handle
+        //! @param priority    class index
+        bool set_priority(const handle h, const std::size_t priority) {
+            return clientPool_.set_priority(h, priority);
+        }
+
+        //! @get
+        //! @param priority    class index
+        //! @return            service received by the class, see client_pool::get_priority_stats()
+        priority_stats get_priority_stats(const std::size_t priority) const {
+            return clientPool_.get_priority_stats(priority);
+        }
+
+        //! @get
+        //! Reads the kernel memory of every live connection, one syscall each; meant for diagnostics
+        //! @return memory held by live connections
+        memory_report get_memory_report() const {
+            return clientPool_.get_memory_report();
+        }
+
+        //! Enables strands, to which tasks can be posted per connection; only valid while not running
+        //! @param enable    true to enable strands
+        bool set_strands(const bool enable) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_strands(enable);
+        }
+
+        //! Runs task on the strand of a connection, after the tasks posted before it; see client_pool::post()
+        //! @param h       connection handle
+        //! @param task    callable taking (handle, int sfd, Tctx&)
+        template <typename F>
+        bool post(const handle h, F task) {
+            return clientPool_.post(h, std::move(task));
+        }
+
+        //! Creates the message mesh used by send(); only valid while not running
+        //! @param capacity    maximum number of queued messages from one worker to one lane of connections
+        bool set_mesh(const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_mesh(capacity);
+        }
+
+        //! Creates the sequencer used by publish(); only valid while not running
+        //! @param capacity    maximum number of published messages not yet processed
+        bool set_sequencer(const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_sequencer(capacity);
+        }
+
+        //! Publishes message to the sequencer, see client_pool::publish()
+        //! @param h       connection the message came from
+        //! @param data    message
+        //! @param size    message length
+        bool publish(const handle h, const char* data, const std::size_t size) {
+            return clientPool_.publish(h, data, size);
+        }
+
+        //! Registers every worker with an epoch domain, see client_pool::set_epoch_domain(); only valid while not running
+        //! @param domain    epoch domain, which outlives the server
+        bool set_epoch_domain(epoch_domain* domain) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_epoch_domain(domain);
+        }
+
+        //! Bounds the events a worker processes per poll, idle workers steal the others, see
+        //! client_pool::set_work_stealing(); only valid while not running, and without priority classes
+        //! @param batch       maximum number of connections processed per poll; 0 disables stealing
+        //! @param capacity    maximum number of deferred connections per worker
+        bool set_work_stealing(const std::size_t batch, const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_work_stealing(batch, capacity);
+        }
+
+        //! Sends message to a connection, see client_pool::send()
+        //! @param h       connection handle
+        //! @param data    message
+        //! @param size    message length
+        bool send(const handle h, const char* data, const std::size_t size) {
+            return clientPool_.send(h, data, size);
+        }
+
+        //! Creates the compute pool that handlers offload work to; only valid while not running
+        //! @param threadCount    number of compute threads
+        //! @param capacity       maximum number of offloaded calls awaiting completion
+        bool set_offload(const std::size_t threadCount, const std::size_t capacity) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            return !running_ && clientPool_.set_offload(threadCount, capacity);
+        }
+
+        //! Starts listening on all server sockets
+        //! The calling thread runs the first acceptor, and this call returns once the server is stopped
+        void run() {
+
+            std::vector<std::thread> threads;
+            cpu_set_t callerSet;
+            bool pinned;
+
+            // Maybe start the server; the lock is not held while accepting, so listeners can be added meanwhile
             {
-                unuse(client);
-                break;
+                std::lock_guard<std::mutex> lock(lock_);
+
+                if (running_) {
+                    return;
+                }
+
+                running_ = true;
+                accepting_ = true;
+                clientPool_.run();
+
+                for (std::size_t i = 1; i < acceptors_.size(); ++i)
+                {
+                    threads.emplace_back(&acceptor<server_pool<T> >::run, acceptors_[i].get());
+
+                    // Acceptor i serves the CPUs that the steering program maps to its listeners
+                    if (steering_) {
+                        detail::pin_thread(threads.back().native_handle(), i, acceptors_.size());
+                    }
+                }
+
+                // The calling thread gets its affinity back once the server stops
+                pinned = steering_
+                    && ::pthread_getaffinity_np(::pthread_self(), sizeof(callerSet), &callerSet) == 0
+                    && detail::pin_thread(::pthread_self(), 0, acceptors_.size());
             }
 
-            case EPOLLIN:
-            case EPOLLIN | EPOLLHUP:
-            case EPOLLIN | EPOLLHUP | EPOLLOUT: // ignore EPOLLOUT
+            acceptors_[0]->run();
+
+            if (pinned) {
+                ::pthread_setaffinity_np(::pthread_self(), sizeof(callerSet), &callerSet);
+            }
+
+            for (std::size_t i = 0; i != threads.size(); ++i) {
+                threads[i].join();
+            }
 
-            case EPOLLIN | EPOLLRDHUP:
-            case EPOLLIN | EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
             {
-                handle_epollin(client); // Also processes hangup (on 0-byte read)
-                break;
+                std::lock_guard<std::mutex> lock(lock_);
+                accepting_ = false;
             }
 
-            case EPOLLPRI:
-            case EPOLLPRI | EPOLLHUP:
-            case EPOLLPRI | EPOLLHUP | EPOLLOUT: // ignore EPOLLOUT
+            accepted_.notify_all();
+        }
 
-            case EPOLLPRI | EPOLLRDHUP:
-            case EPOLLPRI | EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
+        //! Stops listening on all server sockets
+        //!
+        void stop() {
+
+            std::unique_lock<std::mutex> lock(lock_);
+
+            // Maybe stop the server
+            if (running_)
             {
-                handle_epollpri(client); // Also process hangup (on 0-byte read)
-                break;
+                for (std::size_t i = 0; i != acceptors_.size(); ++i) {
+                    acceptors_[i]->stop();
+                }
+
+                // Acceptors hand connections to the client pool until they return
+                accepted_.wait(lock, [this] { return !accepting_; });
+                clientPool_.stop();
+                running_ = false;
             }
+        }
+
+        //! Binds a listener socket to port
+        //! With more than one acceptor, binds one SO_REUSEPORT listener per acceptor; the kernel spreads
+        //! connection requests across them
+        //! @param port           port number
+        //! @param queuelen       backlog queue length for accept()
+        //! @param deferAccept    if non-zero, connections are only accepted once they have data to read,
+        //!                       or after this many seconds (TCP_DEFER_ACCEPT)
+        //! @param cpuSteering    if true and there is more than one acceptor, each connection goes to the listener
+        //!                       of the CPU that received it (CPU % acceptor count), instead of a hashed one;
+        //!                       acceptor and worker threads are then pinned to their CPUs when run() is called
+        bool bind(const int port, const int queuelen, const int deferAccept = 0, const bool cpuSteering = false) {
+
+            socket_options options;
+            options.deferAccept = deferAccept;
+            return bind(port, queuelen, options, cpuSteering);
+        }
+
+        //! Binds a listener socket to port, as above
+        //! @param options    TCP options of the listener and of the connections it accepts; with more than one
+        //!                   acceptor and incomingCpu set, listener i takes CPU incomingCpu + i
+        bool bind(const int port, const int queuelen, const socket_options& options, const bool cpuSteering = false) {
+
+            return listen([port, queuelen](const bool reuseport, const socket_options* options) {
+                return comm::endpoint_tcp_server(port, queuelen, reuseport, options);
+            }, options, cpuSteering);
+        }
+
+        //! Binds a listener socket to a local IPv4 or IPv6 address and port, as above
+        //! @param ipaddr    numeric local address; "::" accepts both IPv4 and IPv6 connections
+        bool bind(const char* ipaddr,
+                  const int port,
+                  const int queuelen,
+                  const int deferAccept = 0,
+                  const bool cpuSteering = false) {
+
+            socket_options options;
+            options.deferAccept = deferAccept;
+            return bind(ipaddr, port, queuelen, options, cpuSteering);
+        }
+
+        //! Binds a listener socket to a local IPv4 or IPv6 address and port, with a socket option profile
+        bool bind(const char* ipaddr,
+                  const int port,
+                  const int queuelen,
+                  const socket_options& options,
+                  const bool cpuSteering = false) {
+
+            return listen([ipaddr, port, queuelen](const bool reuseport, const socket_options* options) {
+                return comm::endpoint_tcp_server(ipaddr, port, queuelen, reuseport, false, options);
+            }, options, cpuSteering);
+        }
+
+        //! Binds a Unix-domain listener socket; every acceptor waits on it, and the socket file is removed
+        //! when the server is destroyed
+        //! @param path        file system path; a stale socket file at the path is replaced
+        //! @param queuelen    backlog queue length for accept()
+        bool bind_unix(const char* path, const int queuelen) {
 
-            case EPOLLIN | EPOLLPRI:
-            case EPOLLIN | EPOLLPRI | EPOLLHUP:
-            case EPOLLIN | EPOLLPRI | EPOLLHUP | EPOLLOUT: // ignore EPOLLOUT
+            std::lock_guard<std::mutex> lock(lock_);
 
-            case EPOLLIN | EPOLLPRI | EPOLLRDHUP:
-            case EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLOUT: // ignore EPOLLOUT
-            {
-                handle_epollpri(client); // Also processes hangup (on 0-byte read)
-                break;
-            }
+            int sfd;
+            if ((sfd = comm::endpoint_unix_server(path, queuelen)) == -1)
+                return false;
 
-            case EPOLLOUT:
-            {
-                handle_epollout(client);
-                break;
+            listeners_.push_back(sfd);
+            listenerOwners_.push_back(-1);
+
+            bool ret = comm::endpoint_unblock(sfd) != -1;
+            for (std::size_t i = 0; ret && i != acceptors_.size(); ++i) {
+                ret = acceptors_[i]->add(sfd);
             }
 
-            case EPOLLIN | EPOLLOUT:
+            if (!ret)
             {
-                handle_epollin(client);
-                handle_epollout(client);
-                break;
+                unlisten(listeners_.size() - 1);
+                ::unlink(path);
+                return false;
             }
 
-            case EPOLLPRI | EPOLLOUT:
-            {
-                handle_epollpri(client);
-                handle_epollout(client);
-                break;
+            paths_.push_back(path);
+            ++listenerCount_;
+            return true;
+        }
+
+        //! Passes listeners and live connections to a process waiting in take_over(), then stops
+        //! Connections keep their socket, along with any data not yet read; new connections wait in the listener
+        //! backlogs meanwhile. Listeners passed to add() are not handed off.
+        //! @param path    file system path the other process listens on
+        //! @return        false if the other process could not be reached, or the handoff failed midway; in the
+        //!                latter case, connections that were not handed off are closed
+        bool hand_off(const char* path) {
+
+            handoff_channel channel;
+            if (!channel.connect(path)) {
+                return false;
             }
 
-            case EPOLLIN | EPOLLPRI | EPOLLOUT:
+            std::unique_lock<std::mutex> lock(lock_);
+
+            if (running_)
             {
-                handle_epollpri(client);
-                handle_epollout(client);
-                break;
+                for (std::size_t i = 0; i != acceptors_.size(); ++i) {
+                    acceptors_[i]->stop();
+                }
+
+                accepted_.wait(lock, [this] { return !accepting_; });
             }
 
-            default:
+            bool ret = true;
+            for (std::size_t i = 0; i != listeners_.size(); ++i)
             {
-                // Have error, close the socket
-                if ((flags & EPOLLERR) == EPOLLERR) {
-                    unuse(client);
+                std::uint32_t flags = 0;
+                if (quick_ack(listeners_[i])) {
+                    flags |= handoff_listener::QUICK_ACK;
                 }
-            }
-        }
-    }
 
-    /*! EPOLLOUT
-     */
-    template <typename Tderiv>
-    void client_pool<Tderiv>::handle_epollout(client* const cl)
-    {
-        static_cast<Tderiv*>(this)->on_write_ready(cl->sfd);
-    }
+                if (steering_) {
+                    flags |= handoff_listener::STEERING;
+                }
 
-    /*! EPOLLIN
-     */
-    template <typename Tderiv>
-    void client_pool<Tderiv>::handle_epollin(client* const cl)
-    {
-        while (true)
-        {
-            int nbytes;
-            switch (nbytes = endpoint_read(cl->sfd, cl->buff, static_cast<int>(cl->size)))
+                ret = channel.add_listener(listeners_[i], flags, listenerOwners_[i]) && ret;
+            }
+
+            // Parked connections are handed off too; they have no state yet
             {
-                case -1:
-                {
-                    if (errno != EAGAIN)
-                        unuse(cl); // Have actual error - done with client
-                    else
-                        epoll<client_pool>::rearm(cl);
-                    return;
-                }
+                std::lock_guard<std::mutex> pendingLock(pendingLock_);
 
-                case 0:
+                for (std::size_t i = 0; i != pending_.size(); ++i)
                 {
-                    unuse(cl); // Disconnection - done with client
-                    return;
+                    ret = channel.add_client(pending_[i].first, pending_[i].second, 0, std::string()) && ret;
+                    endpoint_close(pending_[i].first);
                 }
 
-                // Have data to process...
-                default:
-                {
-                    static_cast<Tderiv*>(this)->on_input(cl->sfd, cl->buff, nbytes);
-                    break;
+                pending_.clear();
+                throttled_.clear();
+                backlogged_.store(false);
+            }
+
+            clientPool_.hand_off(channel);
+            ret = channel.finish() && ret;
+
+            // The other process owns the listeners now, including the socket files
+            for (std::size_t i = 0; i != listeners_.size(); ++i)
+            {
+                for (std::size_t j = 0; j != acceptors_.size(); ++j) {
+                    acceptors_[j]->remove(listeners_[i]);
                 }
+
+                endpoint_close(listeners_[i]);
             }
+
+            listeners_.clear();
+            listenerOwners_.clear();
+            paths_.clear();
+            quickAck_.clear();
+            listenerCount_ = 0;
+            running_ = false;
+            return ret;
         }
-    }
 
-    /*! EPOLLPRI
-     */
-    template <typename Tderiv>
-    void client_pool<Tderiv>::handle_epollpri(client* const cl)
-    {
-        while (true)
-        {
-            int mark;
-            if (::ioctl(cl->sfd, SIOCATMARK, &mark) == -1)
-            {
-                unuse(cl); // Have actual error - done with client
-                break;
+        //! Waits for a process calling hand_off(), and adopts its listeners and connections; only valid while not
+        //! running. The acceptor count should match the other process.
+        //! @param path       file system path to listen on; removed once the other process has connected
+        //! @param timeout    milliseconds to wait for the other process, -1 waits indefinitely
+        //! @return           false if the other process did not connect in time, or the handoff failed midway
+        bool take_over(const char* path, const int timeout = -1) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            handoff_channel channel;
+            if (running_ || !channel.accept(path, timeout)) {
+                return false;
             }
 
-            else
-            {
-                if (mark)
-                {
-                    char oobdata;
-                    if (endpoint_read_oob(cl->sfd, &oobdata) != -1)
-                        on_oob(cl->sfd, oobdata);
+            std::size_t listeners = 0;
+            const bool ret = channel.receive([this, &listeners](const int sfd, const std::uint32_t flags, const int owner) {
 
-                    else
-                    {
-                        unuse(cl); // Have actual error - done with client
-                        break;
-                    }
+                listeners_.push_back(sfd);
+                listenerOwners_.push_back(owner >= 0 ? owner % static_cast<int>(acceptors_.size()) : -1);
+                ++listeners;
+
+                if (flags & handoff_listener::QUICK_ACK) {
+                    quickAck_.push_back(sfd);
                 }
-            }
 
-            int nbytes;
-            switch ((nbytes = endpoint_read(cl->sfd, cl->buff, static_cast<int>(cl->size))))
-            {
-                case -1:
+                if (flags & handoff_listener::STEERING)
                 {
-                    if (errno != EAGAIN)
-                        unuse(cl); // Have actual error - done with client
-                    else
-                        epoll<client_pool>::rearm(cl);
-                    return;
+                    steering_ = true;
+                    clientPool_.set_worker_affinity(true);
                 }
 
-                case 0:
+                // Socket files of Unix-domain listeners are removed by this process from now on
+                sockaddr_storage addr;
+                socklen_t size = sizeof(addr);
+                if (::getsockname(sfd, reinterpret_cast<sockaddr*>(&addr), &size) == 0 && addr.ss_family == AF_UNIX)
                 {
-                    unuse(cl); // Disconnection - done with client
-                    return;
+                    const sockaddr_un* un = reinterpret_cast<const sockaddr_un*>(&addr);
+                    if (size > offsetof(sockaddr_un, sun_path) && un->sun_path[0] != '\0') {
+                        paths_.push_back(std::string(un->sun_path, ::strnlen(un->sun_path, size - offsetof(sockaddr_un, sun_path))));
+                    }
                 }
 
-                // Have data to process...
-                default:
+                for (std::size_t i = 0; i != acceptors_.size(); ++i)
                 {
-                    static_cast<Tderiv*>(this)->on_input(cl->sfd, cl->buff, nbytes);
-                    break;
+                    if (owner < 0 || static_cast<int>(i) == listenerOwners_.back()) {
+                        acceptors_[i]->add(sfd, (flags & handoff_listener::QUICK_ACK) != 0);
+                    }
                 }
+            },
+            [this](const int sfd, const peer_address& peer, const std::uint64_t received, const char* state, const std::size_t size) {
+
+                if (!clientPool_.adopt_client(sfd, peer, received, state, size)) {
+                    endpoint_close(sfd);
+                }
+            });
+
+            if (listeners != 0) {
+                ++listenerCount_;
             }
+
+            return ret;
         }
-    }
 
-    //! @class server_pool
-    /*! encapsulates event handling for multiple server sockets and their clients
-     */
-    template <typename T>
-    class server_pool : public server_pool_base, public epoll<server_pool<T> > {
-    public:
+        //! Adds a listener socket; every acceptor waits on it
+        //! @param sfd    file descriptor
+        bool add(const int sfd) {
 
-        //! ctor.
-        //! @param workerCount     number of client handler thread
-        //! @param clientCap    maximum number of clients
-        server_pool(const std::size_t workerCount,
-                    const std::size_t clientCap) : clientPool_(workerCount, clientCap) {}
+            std::lock_guard<std::mutex> lock(lock_);
 
-        ::size_t get_active_count() const {
-            return clientPool_.get_active_count();
+            for (std::size_t i = 0; i != acceptors_.size(); ++i)
+            {
+                if (!acceptors_[i]->add(sfd))
+                    return false;
+            }
+
+            ++listenerCount_;
+            return true;
         }
 
-        //! Starts listening on all server sockets
-        //!
-        void run() {
+    private:
+
+        friend acceptor<server_pool<T> >;
+
+        static const std::size_t ACCEPT_BATCH_SIZE = 64;
+
+        /*! Creates one listener per acceptor with the given function, which takes the reuseport flag and options
+         */
+        template <typename F>
+        bool listen(F create, const socket_options& options, const bool cpuSteering) {
 
             std::lock_guard<std::mutex> lock(lock_);
 
-            // Maybe start the server
-            if (threadCount_.load() == 0)
+            const std::size_t first = listeners_.size();
+            const bool reuseport = acceptors_.size() > 1;
+            for (std::size_t i = 0; i != acceptors_.size(); ++i)
             {
-                clientPool_.run();
-                // Start server
-                // Server instance listens on only one thread
-                threadCount_ = 1;
-                epoll<server_pool<T> >::wait(threadCount_);
+                socket_options listenerOptions = options;
+                if (options.incomingCpu >= 0) {
+                    listenerOptions.incomingCpu += static_cast<int>(i);
+                }
+
+                int sfd;
+                if ((sfd = create(reuseport, &listenerOptions)) == -1)
+                {
+                    unlisten(first);
+                    return false;
+                }
+
+                listeners_.push_back(sfd);
+                listenerOwners_.push_back(static_cast<int>(i));
+
+                // The only option that accepted sockets do not inherit
+                if (options.quickAck) {
+                    quickAck_.push_back(sfd);
+                }
+
+                if (comm::endpoint_unblock(sfd) == -1 || !acceptors_[i]->add(sfd, options.quickAck))
+                {
+                    unlisten(first);
+                    return false;
+                }
+            }
+
+            // The program applies to the whole group, so it is attached once every listener has joined
+            if (cpuSteering && reuseport)
+            {
+                if (comm::endpoint_reuseport_by_cpu(listeners_[first], static_cast<unsigned>(acceptors_.size())) == -1)
+                {
+                    unlisten(first);
+                    return false;
+                }
+
+                steering_ = true;
+                clientPool_.set_worker_affinity(true);
             }
+
+            ++listenerCount_;
+            return true;
         }
 
-        //! Stops listening on all server sockets
-        //!
-        void stop() {
+        /*! Closes the listeners from index first on, created by a listen() or bind_unix() call that failed midway
+         */
+        void unlisten(const std::size_t first) {
 
-            int threadCount = threadCount_.load();
-            // Maybe stop the server
-            // Server instance listens on only one thread
-            if (threadCount == 1)
+            for (std::size_t i = first; i != listeners_.size(); ++i)
             {
-                epoll<server_pool<T> >::close();
+                for (std::size_t j = 0; j != acceptors_.size(); ++j) {
+                    acceptors_[j]->remove(listeners_[i]);
+                }
 
-                std::lock_guard<std::mutex> lock(lock_);
-                clientPool_.stop();
+                quickAck_.erase(std::remove(quickAck_.begin(), quickAck_.end(), listeners_[i]), quickAck_.end());
+                endpoint_close(listeners_[i]);
             }
+
+            listeners_.resize(first);
+            listenerOwners_.resize(first);
         }
 
-        //! Binds a listener socket to port
-        //! @param port        port number
-        //! @param queuelen    backlog queue length for accept()
-        bool bind(const int port, const int queuelen) {
+        /*! Called by acceptors to handle connection requests
+         */
+        inline void process(const int sfd, const bool quickAck, const int flags);
 
-            int sfd;
-            if ((sfd = comm::endpoint_tcp_server(port, queuelen)) == -1
-                || comm::endpoint_unblock(sfd) == -1)
-                return false;
+        /*! Accepts connections until the backlog is empty, or workers are overloaded
+         */
+        inline void accept(const int sfd, const bool quickAck);
 
-            const int ret = epoll<server_pool<T> >::add(sfd);
-            return ret == 0;
-        }
+        /*! Parks connections while workers are overloaded, and marks the listener for later
+         */
+        inline void park(const int sfd, const bool quickAck);
 
-        //! Adds a listener socket
-        //! @param sfd    file descriptor
-        bool add(const int sfd) {
+        /*! Called by acceptors after every poll; resumes accepting once workers are no longer overloaded
+         */
+        void on_wait() {
 
-            const int ret = epoll<server_pool<T> >::add(sfd);
-            return ret == 0;
+            if (backlogged_.load(std::memory_order_relaxed) && !overloaded()) {
+                resume();
+            }
         }
 
-    private:
-
-        friend epoll<server_pool<T> >;
+        /*! Hands parked connections to the client pool a batch at a time, then accepts from the marked listeners
+         */
+        inline void resume();
 
-        /*! Called on epoll event, casts epoll data value to correct type before passing it to process()
+        /*! Returns true if connections accepted on the listener are set to TCP_QUICKACK; lock held
+         *! Acceptors get the flag along with each event instead
          */
-        int cast(epoll_data data) {
-            return static_cast<int>(data.u32);
+        bool quick_ack(const int sfd) const {
+            return !quickAck_.empty() && std::find(quickAck_.begin(), quickAck_.end(), sfd) != quickAck_.end();
         }
 
-        /*! Called on epoll event to handle connection requests
+        /*! Returns true if worker load is beyond a threshold
          */
-        inline void process(const int sfd, const int flags);
+        bool overloaded() const {
+
+            return (throttle_.maxLag != 0 && clientPool_.get_lag() > throttle_.maxLag)
+                || (throttle_.maxDepth != 0 && clientPool_.get_depth() > throttle_.maxDepth);
+        }
 
         T                        clientPool_;
-        std::atomic<std::size_t> threadCount_; // Current number of running threads
+        memory_resource*         resource_;
+
+        std::vector<std::unique_ptr<acceptor<server_pool<T> > > > acceptors_;
+        std::vector<int>         listeners_; // Listener sockets created by bind()
+        std::vector<int>         listenerOwners_; // Acceptor that waits on each listener, -1 if every acceptor does
+        std::vector<std::string> paths_; // Socket files created by bind_unix()
+        std::size_t              listenerCount_; // # of calls to bind() and add()
+        std::vector<int>         quickAck_; // Listeners whose connections are set to TCP_QUICKACK
+        bool                     steering_; // Listeners steer connections by CPU, threads are pinned
+
+        // Throttling
+        accept_throttle          throttle_;
+        bool                     throttling_; // Accepting backs off while workers are overloaded
+        std::atomic<bool>        backlogged_; // Connections are parked, or left in a listener backlog
+        std::deque<std::pair<int, peer_address> > pending_; // Parked connections
+        std::vector<std::pair<int, bool> > throttled_; // Listeners with connections left in the backlog, quick-ack flag
+        mutable std::mutex       pendingLock_;
+
+        bool                     accepting_; // Acceptors have not all returned from run()
+        std::condition_variable  accepted_; // Signalled once they have
+        std::atomic<bool>        running_;
         mutable std::mutex       lock_;
     };
 
     /*! Called on epoll event to handle connection requests
      */
     template <typename T>
-    void server_pool<T>::process(const int sfd, const int flags)
+    void server_pool<T>::process(const int sfd, const bool quickAck, const int flags)
     {
         switch (flags)
         {
@@ -497,16 +4348,113 @@ namespace comm {
 
             default:
             {
-                int cfd;
-                while ((cfd = endpoint_accept(sfd)) != -1)
-                {
-                    if (endpoint_unblock(cfd) != 0
-                        || !clientPool_.add_client(cfd)) {
-                        endpoint_close(cfd);
-                    }
+                accept(sfd, quickAck);
+            }
+        }
+    }
+
+    /*! Accepts connections until the backlog is empty, or workers are overloaded
+     */
+    template <typename T>
+    void server_pool<T>::accept(const int sfd, const bool quickAck)
+    {
+        // Accept in batches, then hand each batch to the client pool, which applies the admission policy
+        int cfds[ACCEPT_BATCH_SIZE];
+        peer_address peers[ACCEPT_BATCH_SIZE];
+
+        std::size_t count;
+        do
+        {
+            // Parked connections go first
+            if (throttling_ && (backlogged_.load(std::memory_order_relaxed) || overloaded()))
+            {
+                park(sfd, quickAck);
+                return;
+            }
+
+            count = 0;
+
+            sockaddr_storage addr;
+            while (count != ACCEPT_BATCH_SIZE
+                   && (cfds[count] = endpoint_accept_nonblock(sfd, &addr)) != -1)
+            {
+                if (quickAck) {
+                    endpoint_quickack(cfds[count]);
                 }
+
+                peers[count++] = peer_address(reinterpret_cast<const sockaddr*>(&addr));
+            }
+
+            for (std::size_t i = clientPool_.add_clients(cfds, peers, count); i != count; ++i) {
+                endpoint_close(cfds[i]);
+            }
+        }
+        while (count == ACCEPT_BATCH_SIZE);
+    }
+
+    /*! Parks connections while workers are overloaded, and marks the listener for later
+     */
+    template <typename T>
+    void server_pool<T>::park(const int sfd, const bool quickAck)
+    {
+        std::lock_guard<std::mutex> lock(pendingLock_);
+
+        int cfd;
+        sockaddr_storage addr;
+        while (pending_.size() < throttle_.pendingCap
+               && (cfd = endpoint_accept_nonblock(sfd, &addr)) != -1)
+        {
+            if (quickAck) {
+                endpoint_quickack(cfd);
+            }
+
+            pending_.push_back(std::make_pair(cfd, peer_address(reinterpret_cast<const sockaddr*>(&addr))));
+        }
+
+        // The rest stays in the kernel backlog; being edge triggered, the listener will not signal it again
+        const std::pair<int, bool> listener(sfd, quickAck);
+        if (std::find(throttled_.begin(), throttled_.end(), listener) == throttled_.end()) {
+            throttled_.push_back(listener);
+        }
+
+        backlogged_.store(true);
+    }
+
+    /*! Hands parked connections to the client pool a batch at a time, then accepts from the marked listeners
+     */
+    template <typename T>
+    void server_pool<T>::resume()
+    {
+        int cfds[ACCEPT_BATCH_SIZE];
+        peer_address peers[ACCEPT_BATCH_SIZE];
+
+        std::size_t count = 0;
+        std::vector<std::pair<int, bool> > listeners;
+        {
+            std::lock_guard<std::mutex> lock(pendingLock_);
+
+            for (; count != ACCEPT_BATCH_SIZE && !pending_.empty(); ++count)
+            {
+                cfds[count] = pending_.front().first;
+                peers[count] = pending_.front().second;
+                pending_.pop_front();
+            }
+
+            // Load is re-checked before the next batch
+            if (pending_.empty())
+            {
+                listeners.swap(throttled_);
+                backlogged_.store(false);
             }
         }
+
+        for (std::size_t i = clientPool_.add_clients(cfds, peers, count); i != count; ++i) {
+            endpoint_close(cfds[i]);
+        }
+
+        for (std::size_t i = 0; i != listeners.size(); ++i) {
+            accept(listeners[i].first, listeners[i].second);
+        }
     }
 }
 
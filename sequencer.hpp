@@ -0,0 +1,243 @@
+/* sequencer.hpp -- v1.0 -- ring of preallocated entries, published by many threads and processed in order by one
+   Author: Sam Y. 2026 */
+
+#ifndef _COMM_SEQUENCER_HPP
+#define _COMM_SEQUENCER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "mem.hpp"
+
+namespace comm {
+
+    //! @class sequencer
+    /*! disruptor-style ring: producers claim a sequence number with one atomic increment, fill the entry in place
+     *! and mark it published; a single consumer thread processes published entries in sequence order, in batches,
+     *! without locks, and releases the whole batch at once. Entries are constructed once and reused, so values that
+     *! keep their capacity, e.g. strings, are not reallocated.
+     *! idle consumer spins briefly, then sleeps until the next entry is published
+     */
+    template <typename T>
+    class sequencer {
+    public:
+
+        //! dtor.
+        //!
+        ~sequencer() {
+
+            stop();
+
+            for (std::size_t i = 0; i != capacity_; ++i) {
+                slots_[i].~slot();
+            }
+
+            resource_->deallocate(slots_, sizeof(slot) * capacity_, alignof(slot));
+        }
+
+        //! ctor.
+        //! @param capacity    maximum number of published entries not yet processed, rounded up to a power of two
+        //! @param resource    memory resource used for the entries
+        explicit sequencer(const std::size_t capacity, memory_resource* resource = get_heap_resource())
+            : resource_(resource)
+            , capacity_(2)
+            , stopping_(true)
+            , sleeping_(false)
+            , cursor_(CLOSED)
+            , consumed_(0) {
+
+            while (capacity_ < capacity) {
+                capacity_ <<= 1;
+            }
+
+            mask_ = capacity_ - 1;
+            slots_ = static_cast<slot*>(resource_->allocate(sizeof(slot) * capacity_, alignof(slot)));
+
+            for (std::size_t i = 0; i != capacity_; ++i) {
+                new (&slots_[i]) slot();
+            }
+        }
+
+        //! @get
+        //! @return maximum number of entries not yet processed
+        std::size_t get_capacity() const {
+            return capacity_;
+        }
+
+        //! @get
+        //! @return number of claimed entries not yet processed; approximate
+        std::size_t get_size() const {
+
+            // Entries claimed once the cursor is closed are given up
+            const std::size_t claimed = cursor_.load(std::memory_order_relaxed);
+            const std::size_t consumed = consumed_.load(std::memory_order_relaxed);
+            return (claimed & CLOSED) == 0 && claimed > consumed ? claimed - consumed : 0;
+        }
+
+        /*! Claims the next entry, fills it and publishes it; waits while the ring is full
+         *! @param fill    callable taking (T&), called on the claimed entry
+         *! @return        false if the consumer has not started, or has stopped
+         */
+        template <typename F>
+        bool publish(F fill) {
+
+            const std::size_t sequence = cursor_.fetch_add(1);
+
+            // Claimed after the consumer exited; the entry is given up, see run()
+            if (sequence & CLOSED) {
+                return false;
+            }
+
+            // The consumer processes every claimed entry before exiting, so this wait ends
+            while (sequence - consumed_.load(std::memory_order_acquire) >= capacity_) {
+                std::this_thread::yield();
+            }
+
+            slot& s = slots_[sequence & mask_];
+            fill(s.value);
+            s.sequence.store(sequence + 1);
+
+            // Pairs with the check made by the consumer before it sleeps
+            if (sleeping_.load())
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                wake_.notify_one();
+            }
+
+            return true;
+        }
+
+        /*! Starts the consumer thread
+         *! @param handler    callable taking (T&, bool endOfBatch), called on each entry in sequence order
+         */
+        template <typename F>
+        void run(F handler) {
+
+            std::lock_guard<std::mutex> lock(lock_);
+
+            if (!thread_.joinable())
+            {
+                // Entries claimed while stopped were given up; their sequence numbers are reused
+                cursor_.store(consumed_.load());
+                stopping_ = false;
+                thread_ = std::thread(&sequencer::consume<F>, this, handler);
+            }
+        }
+
+        /*! Stops the consumer thread, once every claimed entry is processed; later calls to publish() fail
+         */
+        void stop() {
+
+            std::thread thread;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+
+                stopping_ = true;
+                thread.swap(thread_);
+                wake_.notify_all();
+            }
+
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+
+    private:
+
+        // Failed polls before the consumer goes to sleep
+        static const int SPIN_COUNT = 256;
+        // Set on the cursor once the consumer exits
+        static const std::size_t CLOSED = ~(~static_cast<std::size_t>(0) >> 1);
+        static const std::size_t CACHE_LINE = 64;
+
+        // Ring entry; sequence is one past the sequence number last published to the entry
+        struct slot {
+            std::atomic<std::size_t> sequence;
+            T value;
+
+            //! ctor.
+            slot() : sequence(0), value() {}
+        };
+
+        /*! Consumer thread
+         */
+        template <typename F>
+        void consume(F handler) {
+
+            std::size_t next = consumed_.load();
+            int spins = 0;
+            while (true)
+            {
+                // Every entry published in sequence order is taken as one batch
+                std::size_t end = next;
+                while (end - next != capacity_ && slots_[end & mask_].sequence.load(std::memory_order_acquire) == end + 1) {
+                    ++end;
+                }
+
+                if (end != next)
+                {
+                    for (std::size_t sequence = next; sequence != end; ++sequence) {
+                        handler(slots_[sequence & mask_].value, sequence + 1 == end);
+                    }
+
+                    // Producers waiting for the ring to wrap go on
+                    next = end;
+                    consumed_.store(next, std::memory_order_release);
+                    spins = 0;
+                    continue;
+                }
+
+                // Exits once every claimed entry is processed; producers that claim later find the cursor closed
+                std::size_t claimed = next;
+                if (stopping_.load() && cursor_.compare_exchange_strong(claimed, next | CLOSED)) {
+                    return;
+                }
+
+                if (++spins < SPIN_COUNT)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(lock_);
+
+                // An entry published after this store finds the consumer sleeping, and wakes it
+                sleeping_.store(true);
+                if (slots_[next & mask_].sequence.load() != next + 1 && !stopping_.load()) {
+                    wake_.wait(lock);
+                }
+                sleeping_.store(false);
+
+                spins = 0;
+            }
+        }
+
+        memory_resource* resource_;
+        std::size_t capacity_;
+        std::size_t mask_;
+        slot* slots_;
+
+        std::thread thread_;
+        std::atomic<bool> stopping_;
+        std::atomic<bool> sleeping_; // Consumer waits for an entry
+        std::mutex lock_;
+        std::condition_variable wake_;
+
+        // Producers and consumer each keep to their own cache line
+        char pad0_[CACHE_LINE];
+        std::atomic<std::size_t> cursor_; // Next sequence number to claim, with CLOSED once the consumer exits
+        char pad1_[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::size_t> consumed_; // Sequence numbers below are processed
+        char pad2_[CACHE_LINE - sizeof(std::atomic<std::size_t>)];
+
+        // Non-copyable object
+        explicit sequencer(sequencer&) = delete;
+        explicit sequencer(const sequencer&) = delete;
+    };
+}
+
+#endif
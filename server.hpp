@@ -1,18 +1,22 @@
 /* server.hpp -- v1.0 -- meta-include file, contains typedefs to important classes
-   Author: Sam Y. 2021 */
+   Author: Sam Y. 2021
+
+   server.hpp -- v1.1
+   Modified: Includes the multi-process supervisor */
 
 #ifndef _COMM_SERVER_HPP
 #define _COMM_SERVER_HPP
 
 #include "pool.hpp"
+#include "supervisor.hpp"
 
 namespace comm {
 
     template <typename T>
     using server = comm::server_pool<T>;
 
-    template <typename T>
-    using client_callback_handler = comm::client_pool<T>;
+    template <typename T, typename Tctx = no_context>
+    using client_callback_handler = comm::client_pool<T, Tctx>;
 }
 
 #endif
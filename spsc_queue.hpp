@@ -0,0 +1,143 @@
+/* spsc_queue.hpp -- v1.0 -- bounded single-producer, single-consumer ring
+   Author: Sam Y. 2026 */
+
+#ifndef _COMM_SPSC_QUEUE_HPP
+#define _COMM_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mem.hpp"
+
+namespace comm {
+
+    //! @class spsc_queue
+    /*! bounded FIFO ring for one producer and one consumer thread at a time; a push or pop takes one store to an
+     *! index the other side reads, and no read-modify-write. Each side keeps a copy of the other's index, and only
+     *! reloads it when the ring looks full or empty.
+     *! Producer or consumer may change, provided the change is synchronized, e.g. by a lock or a thread join
+     */
+    template <typename T>
+    class spsc_queue {
+    public:
+
+        //! dtor.
+        //!
+        ~spsc_queue() {
+
+            // Values left over; no producer or consumer is running
+            const std::size_t end = tail_.load();
+            for (std::size_t pos = head_.load(); pos != end; ++pos) {
+                reinterpret_cast<T*>(&cells_[pos & mask_])->~T();
+            }
+
+            resource_->deallocate(cells_, sizeof(cell) * capacity_, alignof(cell));
+        }
+
+        //! ctor.
+        //! @param capacity    maximum number of queued values, rounded up to a power of two
+        //! @param resource    memory resource used for the slots
+        explicit spsc_queue(const std::size_t capacity, memory_resource* resource = get_heap_resource())
+            : resource_(resource)
+            , capacity_(2)
+            , tail_(0)
+            , cachedHead_(0)
+            , head_(0)
+            , cachedTail_(0) {
+
+            while (capacity_ < capacity) {
+                capacity_ <<= 1;
+            }
+
+            mask_ = capacity_ - 1;
+            cells_ = static_cast<cell*>(resource_->allocate(sizeof(cell) * capacity_, alignof(cell)));
+        }
+
+        //! @get
+        //! @return maximum number of queued values
+        std::size_t get_capacity() const {
+            return capacity_;
+        }
+
+        //! @get
+        //! @return number of queued values; approximate while the queue is in use
+        std::size_t get_size() const {
+
+            const std::size_t tail = tail_.load(std::memory_order_acquire);
+            const std::size_t head = head_.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        /*! Appends value; producer only
+         *! @return false if the queue is full
+         */
+        template <typename U>
+        bool push(U&& value) {
+
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - cachedHead_ == capacity_)
+            {
+                cachedHead_ = head_.load(std::memory_order_acquire);
+                if (tail - cachedHead_ == capacity_) {
+                    return false;
+                }
+            }
+
+            new (&cells_[tail & mask_]) T(std::forward<U>(value));
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /*! Removes the oldest value; consumer only
+         *! @param value    [out] removed value
+         *! @return         false if the queue is empty
+         */
+        bool pop(T& value) {
+
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head == cachedTail_)
+            {
+                cachedTail_ = tail_.load(std::memory_order_acquire);
+                if (head == cachedTail_) {
+                    return false;
+                }
+            }
+
+            T* const stored = reinterpret_cast<T*>(&cells_[head & mask_]);
+            value = std::move(*stored);
+            stored->~T();
+
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+
+        static const std::size_t CACHE_LINE = 64;
+
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type cell;
+
+        memory_resource* resource_;
+        std::size_t capacity_;
+        std::size_t mask_;
+        cell* cells_;
+
+        // Producer and consumer each keep to their own cache line
+        char pad0_[CACHE_LINE];
+        std::atomic<std::size_t> tail_;
+        std::size_t cachedHead_; // Producer's copy of head_
+        char pad1_[CACHE_LINE - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+        std::atomic<std::size_t> head_;
+        std::size_t cachedTail_; // Consumer's copy of tail_
+        char pad2_[CACHE_LINE - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+
+        // Non-copyable object
+        explicit spsc_queue(spsc_queue&) = delete;
+        explicit spsc_queue(const spsc_queue&) = delete;
+    };
+}
+
+#endif
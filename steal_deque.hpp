@@ -0,0 +1,162 @@
+/* steal_deque.hpp -- v1.0 -- bounded work-stealing deque
+   Author: Sam Y. 2026 */
+
+#ifndef _COMM_STEAL_DEQUE_HPP
+#define _COMM_STEAL_DEQUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "mem.hpp"
+
+namespace comm {
+
+    //! @class steal_deque
+    /*! Chase-Lev deque: the owning thread pushes and pops at the bottom without read-modify-write, other threads
+     *! steal from the top with one compare-and-swap; owner and thieves only contend for the last value.
+     *! Values are stored in atomics, so T must be a pointer or integer type
+     */
+    template <typename T>
+    class steal_deque {
+    public:
+
+        //! dtor.
+        //!
+        ~steal_deque() {
+
+            for (std::size_t i = 0; i != capacity_; ++i) {
+                cells_[i].~atomic();
+            }
+
+            resource_->deallocate(cells_, sizeof(std::atomic<T>) * capacity_, alignof(std::atomic<T>));
+        }
+
+        //! ctor.
+        //! @param capacity    maximum number of values, rounded up to a power of two
+        //! @param resource    memory resource used for the slots
+        explicit steal_deque(const std::size_t capacity, memory_resource* resource = get_heap_resource())
+            : resource_(resource)
+            , capacity_(2)
+            , top_(0)
+            , bottom_(0) {
+
+            while (capacity_ < capacity) {
+                capacity_ <<= 1;
+            }
+
+            mask_ = capacity_ - 1;
+            cells_ = static_cast<std::atomic<T>*>(resource_->allocate(sizeof(std::atomic<T>) * capacity_,
+                                                                      alignof(std::atomic<T>)));
+
+            for (std::size_t i = 0; i != capacity_; ++i) {
+                new (&cells_[i]) std::atomic<T>(T());
+            }
+        }
+
+        //! @get
+        //! @return maximum number of values
+        std::size_t get_capacity() const {
+            return capacity_;
+        }
+
+        //! @get
+        //! @return number of values; approximate while the deque is in use
+        std::size_t get_size() const {
+
+            const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+            const std::int64_t top = top_.load(std::memory_order_relaxed);
+            return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+        }
+
+        /*! Appends value at the bottom; owner only
+         *! @return false if the deque is full
+         */
+        bool push(const T value) {
+
+            const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+            const std::int64_t top = top_.load(std::memory_order_acquire);
+            if (bottom - top >= static_cast<std::int64_t>(capacity_)) {
+                return false;
+            }
+
+            // Thieves that see the new bottom see the value, and whatever the owner wrote before pushing it
+            cells_[bottom & mask_].store(value, std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_release);
+            return true;
+        }
+
+        /*! Removes the value at the bottom, the latest pushed; owner only
+         *! @param value    [out] removed value
+         *! @return         false if the deque is empty
+         */
+        bool pop(T& value) {
+
+            const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+            bottom_.store(bottom, std::memory_order_relaxed);
+
+            // Thieves either see the bottom taken back, or win the last value
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t top = top_.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            value = cells_[bottom & mask_].load(std::memory_order_relaxed);
+            if (top == bottom)
+            {
+                // Last value; taken by whoever moves the top first
+                const bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                              std::memory_order_relaxed);
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+            return true;
+        }
+
+        /*! Removes the value at the top, the oldest pushed; any thread
+         *! @param value    [out] removed value
+         *! @return         false if the deque is empty, or another thread took the value first
+         */
+        bool steal(T& value) {
+
+            std::int64_t top = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+            if (top >= bottom) {
+                return false;
+            }
+
+            value = cells_[top & mask_].load(std::memory_order_relaxed);
+            return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+    private:
+
+        static const std::size_t CACHE_LINE = 64;
+
+        memory_resource* resource_;
+        std::size_t capacity_;
+        std::size_t mask_;
+        std::atomic<T>* cells_;
+
+        // Thieves and owner each keep to their own cache line
+        char pad0_[CACHE_LINE];
+        std::atomic<std::int64_t> top_; // Next value to steal
+        char pad1_[CACHE_LINE - sizeof(std::atomic<std::int64_t>)];
+        std::atomic<std::int64_t> bottom_; // Next cell to push to
+        char pad2_[CACHE_LINE - sizeof(std::atomic<std::int64_t>)];
+
+        // Non-copyable object
+        explicit steal_deque(steal_deque&) = delete;
+        explicit steal_deque(const steal_deque&) = delete;
+    };
+}
+
+#endif
@@ -0,0 +1,431 @@
+/* supervisor.hpp -- v1.0 -- runs a server in several processes that share the listeners
+   Author: Sam Y. 2026
+
+   The master process creates the listeners, then forks one process per slot, each running its own server_pool
+   on the inherited listeners. A process that crashes only takes its own connections down; the master restarts
+   it, with a growing delay if it keeps crashing. Each process reports its statistics to a shared memory page,
+   which the master reads. */
+
+#ifndef _COMM_SUPERVISOR_HPP
+#define _COMM_SUPERVISOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "pool.hpp"
+
+namespace comm {
+
+    //! @struct process_stats
+    /* statistics of one server process, in shared memory; updated by the process, read by the master
+     */
+    struct alignas(CACHE_LINE_SIZE) process_stats {
+
+        // Process id, 0 while the process is not running
+        std::atomic<std::int32_t> pid;
+        // Times the process was restarted after exiting on its own
+        std::atomic<std::uint32_t> restarts;
+        // Live connections
+        std::atomic<std::uint64_t> active;
+        // Worker threads
+        std::atomic<std::uint32_t> workers;
+        // Worker utilization in percent; requires load tracking
+        std::atomic<std::uint32_t> utilization;
+        // Time of the latest update, in microseconds of the monotonic clock
+        std::atomic<std::uint64_t> updated;
+    };
+
+    //! @struct supervisor_stats
+    /* statistics of every server process, summed
+     */
+    struct supervisor_stats {
+
+        // Running processes
+        std::size_t running;
+        // Restarts of all processes
+        std::size_t restarts;
+        // Live connections
+        std::size_t active;
+        // Worker threads
+        std::size_t workers;
+        // Mean worker utilization of the running processes, in percent
+        unsigned utilization;
+
+        //! ctor.
+        supervisor_stats() : running(0), restarts(0), active(0), workers(0), utilization(0) {}
+    };
+
+    //! @class supervisor
+    /*! forks processes that each run a server_pool<T> on listeners created by the master
+     *! must be created, bound and run before the master starts any other thread, as forking copies only the
+     *! calling thread
+     */
+    template <typename T>
+    class supervisor {
+    public:
+
+        // Called in each new process before its server runs, with the server and the process slot
+        typedef std::function<void(server_pool<T>&, std::size_t)> setup_function;
+
+        //! dtor.
+        //!
+        ~supervisor() {
+
+            for (std::size_t i = 0; i != listeners_.size(); ++i) {
+                endpoint_close(listeners_[i]);
+            }
+
+            for (std::size_t i = 0; i != paths_.size(); ++i) {
+                ::unlink(paths_[i].c_str());
+            }
+
+            if (stats_ != nullptr) {
+                ::munmap(stats_, sizeof(process_stats) * processCount_);
+            }
+        }
+
+        //! ctor.
+        //! @param processCount    number of server processes
+        //! @param workerCount     worker threads per process
+        //! @param clientCap       maximum number of clients per process
+        supervisor(const std::size_t processCount,
+                   const std::size_t workerCount,
+                   const std::size_t clientCap) : processCount_(std::max<std::size_t>(processCount, 1))
+                                                , workerCount_(workerCount)
+                                                , clientCap_(clientCap)
+                                                , stats_(nullptr)
+                                                , stopping_(false) {
+
+            void* mem = ::mmap(nullptr, sizeof(process_stats) * processCount_, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+
+            // Zero-filled pages; lock-free atomics need no construction, and work across processes
+            stats_ = static_cast<process_stats*>(mem);
+        }
+
+        //! Sets the function that configures the server of each process, before it runs
+        //!
+        void set_setup(const setup_function& setup) {
+
+            setup_ = setup;
+        }
+
+        //! Binds listener sockets to port
+        //! @param port         port number
+        //! @param queuelen     backlog queue length for accept()
+        //! @param reuseport    if true, binds one SO_REUSEPORT listener per process, and the kernel spreads
+        //!                     connection requests across the processes; otherwise every process waits on one
+        //!                     listener. Connections queued on the listener of a crashed process wait for its restart.
+        //! @param options      TCP options of the listeners and of the connections they accept; quickAck is ignored
+        bool bind(const int port,
+                  const int queuelen,
+                  const bool reuseport = true,
+                  const socket_options& options = socket_options()) {
+
+            const std::size_t count = reuseport ? processCount_ : 1;
+            for (std::size_t i = 0; i != count; ++i)
+            {
+                int sfd;
+                if ((sfd = endpoint_tcp_server(port, queuelen, reuseport, &options)) == -1) {
+                    return false;
+                }
+
+                listeners_.push_back(sfd);
+                owners_.push_back(reuseport ? static_cast<int>(i) : -1);
+
+                if (endpoint_unblock(sfd) == -1) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        //! Binds a Unix-domain listener socket that every process waits on; the socket file is removed when the
+        //! supervisor is destroyed
+        //! @param path        file system path
+        //! @param queuelen    backlog queue length for accept()
+        bool bind_unix(const char* path, const int queuelen) {
+
+            int sfd;
+            if ((sfd = endpoint_unix_server(path, queuelen)) == -1) {
+                return false;
+            }
+
+            listeners_.push_back(sfd);
+            owners_.push_back(-1);
+            paths_.push_back(path);
+            return endpoint_unblock(sfd) != -1;
+        }
+
+        //! Forks the server processes, and restarts those that exit until stop() is called
+        //! Returns once every process has exited after stop(), which also takes effect if called before
+        void run() {
+
+            std::vector<std::chrono::steady_clock::time_point> started(processCount_);
+            std::vector<std::chrono::steady_clock::time_point> restart(processCount_);
+            std::vector<std::chrono::milliseconds> delay(processCount_, std::chrono::milliseconds(0));
+
+            for (std::size_t i = 0; i != processCount_; ++i)
+            {
+                started[i] = std::chrono::steady_clock::now();
+                spawn(i);
+            }
+
+            while (true)
+            {
+                // Reap exited processes
+                int status;
+                pid_t pid;
+                while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+                {
+                    for (std::size_t i = 0; i != processCount_; ++i)
+                    {
+                        if (stats_[i].pid.load() != pid) {
+                            continue;
+                        }
+
+                        stats_[i].pid.store(0);
+
+                        // A process that keeps crashing is restarted less and less often
+                        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                        delay[i] = now - started[i] > MAX_RESTART_DELAY
+                            ? std::chrono::milliseconds(0)
+                            : std::min(std::max(delay[i] * 2, MIN_RESTART_DELAY), MAX_RESTART_DELAY);
+                        restart[i] = now + delay[i];
+                    }
+                }
+
+                if (stopping_)
+                {
+                    if (running() == 0)
+                    {
+                        stopping_ = false;
+                        return;
+                    }
+
+                    // Also reaches a process forked while stop() was signalling the others
+                    signal_all();
+                }
+
+                else
+                {
+                    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    for (std::size_t i = 0; i != processCount_; ++i)
+                    {
+                        if (stats_[i].pid.load() == 0 && now >= restart[i])
+                        {
+                            started[i] = now;
+                            ++stats_[i].restarts;
+                            spawn(i);
+                        }
+                    }
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL));
+            }
+        }
+
+        //! Stops the server processes; run() returns once they have exited
+        //! Only sets a flag and sends signals, so it may be called from a signal handler of the master
+        void stop() {
+
+            stopping_ = true;
+            signal_all();
+        }
+
+        //! @get
+        //! @return number of server processes
+        std::size_t get_process_count() const {
+
+            return processCount_;
+        }
+
+        //! @get
+        //! @param index    process slot
+        //! @return         statistics of the process, as last reported
+        const process_stats& get_process_stats(const std::size_t index) const {
+
+            return stats_[index];
+        }
+
+        //! @get
+        //! @return statistics of every process, summed
+        supervisor_stats get_stats() const {
+
+            supervisor_stats stats;
+            unsigned utilization = 0;
+            for (std::size_t i = 0; i != processCount_; ++i)
+            {
+                stats.restarts += stats_[i].restarts.load(std::memory_order_relaxed);
+
+                if (stats_[i].pid.load(std::memory_order_relaxed) == 0) {
+                    continue;
+                }
+
+                ++stats.running;
+                stats.active += stats_[i].active.load(std::memory_order_relaxed);
+                stats.workers += stats_[i].workers.load(std::memory_order_relaxed);
+                utilization += stats_[i].utilization.load(std::memory_order_relaxed);
+            }
+
+            stats.utilization = stats.running != 0 ? utilization / static_cast<unsigned>(stats.running) : 0;
+            return stats;
+        }
+
+    private:
+
+        // Restart delay of a crashing process, doubled on every crash; reset once the process runs for the maximum
+        static const std::chrono::milliseconds MIN_RESTART_DELAY;
+        static const std::chrono::milliseconds MAX_RESTART_DELAY;
+        // Master polls for exited processes, and each process reports its statistics, this often, in milliseconds
+        static const int POLL_INTERVAL = 100;
+
+        std::size_t processCount_;
+        std::size_t workerCount_;
+        std::size_t clientCap_;
+
+        std::vector<int> listeners_;
+        std::vector<int> owners_; // Process slot that waits on each listener, -1 if every process does
+        std::vector<std::string> paths_; // Socket files created by bind_unix()
+        setup_function setup_;
+
+        process_stats* stats_; // One per process slot, shared with the processes
+        std::atomic<bool> stopping_;
+
+        /*! Returns number of running processes
+         */
+        std::size_t running() const {
+
+            std::size_t count = 0;
+            for (std::size_t i = 0; i != processCount_; ++i) {
+                count += stats_[i].pid.load() != 0;
+            }
+
+            return count;
+        }
+
+        /*! Sends SIGTERM to every running process; a process that already received it ignores the repeat
+         */
+        void signal_all() {
+
+            for (std::size_t i = 0; i != processCount_; ++i)
+            {
+                const pid_t pid = stats_[i].pid.load();
+                if (pid != 0) {
+                    ::kill(pid, SIGTERM);
+                }
+            }
+        }
+
+        /*! Forks the process of slot
+         */
+        void spawn(const std::size_t index) {
+
+            // SIGTERM is received by sigtimedwait() in the new process; blocked before any thread starts
+            sigset_t set, previous;
+            sigemptyset(&set);
+            sigaddset(&set, SIGTERM);
+            sigaddset(&set, SIGINT);
+            ::pthread_sigmask(SIG_BLOCK, &set, &previous);
+
+            const pid_t pid = ::fork();
+            if (pid == 0) {
+                ::_exit(serve(index, set));
+            }
+
+            ::pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+            if (pid != -1) {
+                stats_[index].pid.store(pid);
+            }
+        }
+
+        /*! Runs the server of a new process until SIGTERM, reporting its statistics
+         *! @return exit status
+         */
+        int serve(const std::size_t index, const sigset_t& set) {
+
+            // Exit along with the master
+            ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (::getppid() == 1) {
+                return 1;
+            }
+
+            // Listeners of the other slots are not waited on here
+            for (std::size_t i = 0; i != listeners_.size(); ++i)
+            {
+                if (owners_[i] >= 0 && static_cast<std::size_t>(owners_[i]) != index) {
+                    endpoint_close(listeners_[i]);
+                }
+            }
+
+            {
+                server_pool<T> server(workerCount_, clientCap_);
+
+                if (setup_) {
+                    setup_(server, index);
+                }
+
+                for (std::size_t i = 0; i != listeners_.size(); ++i)
+                {
+                    if ((owners_[i] < 0 || static_cast<std::size_t>(owners_[i]) == index) && !server.add(listeners_[i])) {
+                        return 1;
+                    }
+                }
+
+                std::thread thread(&server_pool<T>::run, &server);
+
+                // The stop signal may be pending already, and stop() has no effect until run() has started
+                while (!server.is_running()) {
+                    std::this_thread::yield();
+                }
+
+                process_stats& stats = stats_[index];
+                const timespec timeout = { 0, POLL_INTERVAL * 1000000L };
+                while (::sigtimedwait(&set, nullptr, &timeout) == -1)
+                {
+                    stats.active.store(server.get_active_count(), std::memory_order_relaxed);
+                    stats.workers.store(static_cast<std::uint32_t>(server.get_worker_count()), std::memory_order_relaxed);
+                    stats.utilization.store(server.get_utilization(), std::memory_order_relaxed);
+                    stats.updated.store(detail::clock_us(), std::memory_order_relaxed);
+                }
+
+                server.stop();
+                thread.join();
+            }
+
+            stats_[index].active.store(0);
+            return 0;
+        }
+
+        // Non-copyable object
+        explicit supervisor(supervisor&) = delete;
+        explicit supervisor(const supervisor&) = delete;
+    };
+
+    template <typename T>
+    const std::chrono::milliseconds supervisor<T>::MIN_RESTART_DELAY(100);
+
+    template <typename T>
+    const std::chrono::milliseconds supervisor<T>::MAX_RESTART_DELAY(10000);
+
+    template <typename T>
+    const int supervisor<T>::POLL_INTERVAL;
+}
+
+#endif
@@ -1,5 +1,8 @@
 /* echo.cpp -- v1.1 -- defines a worker class that encapsulates and echo server
-   Author: Sam Y. 2023 */
+   Author: Sam Y. 2023
+
+   echo.cpp -- v1.2
+   Modified: Worker count can be read and set while running, optionally scaled from utilization */
 
 #include "echo.hpp"
 
@@ -45,7 +48,7 @@ namespace {
 
     /*! Helper: Create server socket and client pool
      */
-    inline comm::server<echo>* init_server(int port, int nWorkers, int maxClients, int* svfd)
+    inline comm::server<echo>* init_server(int port, int nWorkers, int maxClients, bool autoscale, int* svfd)
     {
 
         // Create listen socket
@@ -62,7 +65,15 @@ namespace {
             // Initialise pool
             sv = new comm::server<echo>(nWorkers, maxClients);
 
-            if (!sv->add(*svfd)) {
+            // Utilization is shown on the control panel
+            comm::worker_scaling scaling;
+            if (autoscale)
+            {
+                scaling.minWorkers = 1;
+                scaling.maxWorkers = nWorkers;
+            }
+
+            if (!sv->set_load_tracking(true) || !sv->set_worker_scaling(scaling) || !sv->add(*svfd)) {
                 return perror(""), nullptr;
             }
         }
@@ -86,7 +97,7 @@ echo_worker::~echo_worker()
 
 /*! Init. server
  */
-bool echo_worker::create(int port, int nWorkers, int maxClients)
+bool echo_worker::create(int port, int nWorkers, int maxClients, bool autoscale)
 {
     std::lock_guard<std::mutex> lock(lock_);
 
@@ -96,7 +107,7 @@ bool echo_worker::create(int port, int nWorkers, int maxClients)
 
     int svfd;
     comm::server<echo>* sv;
-    if ((sv = init_server(port, nWorkers, maxClients, &svfd)) == nullptr) {
+    if ((sv = init_server(port, nWorkers, maxClients, autoscale, &svfd)) == nullptr) {
         return false;
     }
 
@@ -162,3 +173,42 @@ std::size_t echo_worker::get_active_client_count() const
 
     return sv_->get_active_count();
 }
+
+/*! @get
+ */
+std::size_t echo_worker::get_worker_count() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!sv_.get()) {
+        return 0;
+    }
+
+    return sv_->get_worker_count();
+}
+
+/*! Sets worker count
+ */
+bool echo_worker::set_worker_count(std::size_t count)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!sv_.get()) {
+        return false;
+    }
+
+    return sv_->set_worker_count(count);
+}
+
+/*! @get
+ */
+unsigned echo_worker::get_utilization() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!sv_.get()) {
+        return 0;
+    }
+
+    return sv_->get_utilization();
+}
@@ -1,5 +1,8 @@
 /* echo.hpp -- v1.1 -- defines a worker class that encapsulates and echo server
-   Author: Sam Y. 2023 */
+   Author: Sam Y. 2023
+
+   echo.hpp -- v1.2
+   Modified: Worker count can be read and set while running, optionally scaled from utilization */
 
 #ifndef ECHO_HPP
 #define ECHO_HPP
@@ -22,8 +25,9 @@ public:
     ~echo_worker();
 
     /*! Init. server
+     *! If autoscale is set, workers are scaled between 1 and nWorkers
      */
-    bool create(int port, int nWorkers, int maxClients);
+    bool create(int port, int nWorkers, int maxClients, bool autoscale = false);
 
     /*! Starts server
      */
@@ -41,6 +45,18 @@ public:
      */
     std::size_t get_active_client_count() const;
 
+    /*! @get
+     */
+    std::size_t get_worker_count() const;
+
+    /*! Sets worker count
+     */
+    bool set_worker_count(std::size_t count);
+
+    /*! @get
+     */
+    unsigned get_utilization() const;
+
 private:
 
     mutable std::mutex lock_;
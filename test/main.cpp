@@ -2,7 +2,10 @@
    Author: Sam Y. 2021-22 
 
    main.cpp -- v1.1
-   Modified: Added HTTP interface, 2023 */
+   Modified: Added HTTP interface, 2023
+
+   main.cpp -- v1.2
+   Modified: Added worker autoscaling option */
 
 #include <cstring>
 #include <getopt.h>
@@ -19,11 +22,12 @@ namespace {
      */
     inline void print_usage(const char* app)
     {
-        ::printf("Usage: %s [-nPph]\n"
+        ::printf("Usage: %s [-nPpah]\n"
                  "  [-h, --help]\n"
                  "  [-P, --ctrl=<local port to access the control panel / web interface>] (default: 8080)\n\n"
                  "  [-n, --client-count=<maximum number of clients>] (default: 100,000)\n"
                  "  [-p, --port=<server listen port>]\n"
+                 "  [-a, --autoscale] (scale workers from utilization, up to the worker count)\n"
                  , app);
     }
 }
@@ -36,6 +40,7 @@ int main(int argc, char** argv)
     int workerCount = 10;
     int serverPort = 0;
     int ctrlPanelPort = 0;
+    bool autoscale = false;
 
     // CLI options
     const option longOptions[] = {
@@ -43,12 +48,13 @@ int main(int argc, char** argv)
         { "client-count=", required_argument, nullptr, 'n' },
         { "port=",         required_argument, nullptr, 'p' },
         { "ctrl=",         required_argument, nullptr, 'P' },
+        { "autoscale",     no_argument,       nullptr, 'a' },
         { 0, 0, 0, 0 }
     };
 
     // Parse command line options...
     int opt, optindex;
-    while ((opt = getopt_long(argc, argv, "n:P:p:h", longOptions, &optindex)) != -1)
+    while ((opt = getopt_long(argc, argv, "n:P:p:ah", longOptions, &optindex)) != -1)
     {
         switch (opt)
         {
@@ -114,6 +120,14 @@ int main(int argc, char** argv)
                 break;
             }
 
+            /* Scale workers from utilization
+             */
+            case 'a':
+            {
+                autoscale = true;
+                break;
+            }
+
             /* Bad input, print user message and return
              */
             default:
@@ -143,7 +157,7 @@ int main(int argc, char** argv)
     /* Initialize server
      */
     echo_worker serverWorker;
-    if (!serverWorker.create(serverPort, workerCount, maxClients)) {
+    if (!serverWorker.create(serverPort, workerCount, maxClients, autoscale)) {
         return 1;
     }
 
@@ -1,5 +1,10 @@
 /* run.cpp -- v1.1 -- main program run loop, handles control requests through http
-   Author: Sam Y. 2023 */
+   Author: Sam Y. 2023
+
+   run.cpp -- v1.2
+   Modified: Control panel shows worker count and utilization, and adds or retires workers */
+
+#include <cstdlib>
 
 #include "http/httplib.hpp"
 
@@ -36,6 +41,14 @@ void run(int ctrlPanelPort, echo_worker& serverWorker, int serverPort)
             response += "<div>Connected clients: "
                 + std::to_string(serverWorker.get_active_client_count())
                 + "</div>";
+
+            const std::size_t workerCount = serverWorker.get_worker_count();
+            response += "<div>Workers: "
+                + std::to_string(workerCount)
+                + " (utilization: " + std::to_string(serverWorker.get_utilization()) + "%)"
+                + "   [<a href=\"/set/workers/" + std::to_string(workerCount + 1) + "\">ADD</a>]"
+                + "   [<a href=\"/set/workers/" + std::to_string(workerCount - 1) + "\">RETIRE</a>]"
+                + "</div>";
         }
 
         response += "</body></html>";
@@ -82,6 +95,26 @@ void run(int ctrlPanelPort, echo_worker& serverWorker, int serverPort)
         res.set_content(response, "text/html");
     });
 
+    http.Get(R"(/set/workers/(\d+))", [&](const httplib::Request& req, httplib::Response& res) {
+
+        std::string response = "<html><body>"
+            "<head><style>body { font-family:monospace; font-size: 12px; }</style></head>";
+
+        const std::size_t count = std::strtoul(req.matches[1].str().c_str(), nullptr, 10);
+        if (serverWorker.set_worker_count(count))
+        {
+            response += "<div>Worker count set to " + std::to_string(count) + "</div>";
+        }
+
+        else
+        {
+            response += "<div>Cannot set worker count to " + std::to_string(count) + "</div>";
+        }
+
+        response += "</body></html>";
+        res.set_content(response, "text/html");
+    });
+
     // Print info
     ::fprintf(stdout, "> The control panel can be accessed through local port %d\n\n\n", ctrlPanelPort);
 